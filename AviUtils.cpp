@@ -33,8 +33,14 @@ void write_avi_header(File &fd, uint8_t* buf, int frames, int width, int height,
   
   // Обновляем заголовок потока (stream header)
   fd.seek(0x8C); print_quartet(frames, fd); // Длина потока
-  fd.seek(0xA8); print_quartet(width, fd);
-  fd.seek(0xAC); print_quartet(height, fd);
+  // rcFrame потока (правая и нижняя граница, 16 бит)
+  fd.seek(0xA0);
+  fd.write(width & 0xFF); fd.write((width >> 8) & 0xFF);
+  fd.write(height & 0xFF); fd.write((height >> 8) & 0xFF);
+  
+  // Формат потока (BITMAPINFOHEADER): biWidth и biHeight
+  fd.seek(0xB0); print_quartet(width, fd);
+  fd.seek(0xB4); print_quartet(height, fd);
   
   // Обновляем размер блока movi (где лежат данные видео)
   fd.seek(0xE0); print_quartet(movi_size, fd); 
@@ -116,3 +122,126 @@ void prepare_avi_header_buffer(uint8_t* buf, int width, int height, int fps) {
   
   // Далее следуют данные кадров...
 }
+
+// Открытие нового AVI файла и запись пустого заголовка (будет обновлен в avi_close)
+// idx - буфер индекса на idxCapacity кадров, должен жить до avi_close
+bool avi_open(AviWriter &w, fs::FS &fs, const char* path, int fps, AviIndexEntry* idx, size_t idxCapacity) {
+  if (!idx || idxCapacity == 0) {
+    return false;
+  }
+
+  // Существующий файл не трогаем: имя должно быть новым (см. claimClipNumber)
+  if (fs.exists(path)) {
+    return false;
+  }
+
+  w.file = fs.open(path, FILE_WRITE);
+  if (!w.file) {
+    return false;
+  }
+
+  strlcpy(w.path, path, sizeof(w.path));
+  w.idx = idx;
+  w.idx_capacity = idxCapacity;
+  w.movi_offset = 4;
+  w.frames = 0;
+  w.frames_size = 0;
+  w.width = 0;
+  w.height = 0;
+
+  prepare_avi_header_buffer(w.header, 0, 0, fps);
+  w.file.write(w.header, avi_header_size);
+  return true;
+}
+
+// Запись одного JPEG кадра как чанка "00dc" с выравниванием до 4 байт
+// Возвращает false, если индекс заполнен (кадр не записан)
+bool avi_write_frame(AviWriter &w, const uint8_t* data, size_t len) {
+  if ((size_t)w.frames >= w.idx_capacity) {
+    return false;
+  }
+  w.idx[w.frames] = {w.movi_offset, (uint32_t)len};
+
+  // Запись заголовка чанка
+  w.file.write((uint8_t*)"00dc", 4);
+
+  // Расчет выравнивания (padding)
+  uint32_t rem = len % 4;
+  uint32_t pad = (rem == 0) ? 0 : 4 - rem;
+  uint32_t totalLen = len + pad;
+
+  print_quartet(totalLen, w.file);
+
+  // Запись данных
+  w.file.write(data, len);
+
+  // Запись выравнивания
+  for (int i = 0; i < pad; i++) w.file.write(0);
+
+  w.frames++;
+  w.frames_size += (8 + totalLen);
+  w.movi_offset += (8 + totalLen);
+  return true;
+}
+
+// Запись индекса (idx1), обновление заголовка и закрытие файла
+void avi_close(AviWriter &w, int fps) {
+  w.file.write((uint8_t*)"idx1", 4);
+  uint32_t idx_size = w.frames * 16;
+  print_quartet(idx_size, w.file);
+
+  for (int i = 0; i < w.frames; i++) {
+    w.file.write((uint8_t*)"00dc", 4);
+    print_quartet(16, w.file); // Flags: 0x10 (AVIIF_KEYFRAME)
+    print_quartet(w.idx[i].offset, w.file);
+    print_quartet(w.idx[i].size, w.file);
+  }
+
+  write_avi_header(w.file, w.header, w.frames, w.width, w.height, fps > 0 ? fps : 1, w.frames_size);
+
+  w.file.close();
+  w.idx = nullptr;
+  w.idx_capacity = 0;
+}
+
+// Размер кадра из маркера SOF в JPEG (то, что реально выдал сенсор).
+// Нужен, когда окно сенсора настроено напрямую (ROI) и fb->width/height
+// не соответствуют содержимому кадра.
+bool jpeg_get_dimensions(const uint8_t* data, size_t len, int* width, int* height) {
+  if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return false;
+  }
+
+  size_t pos = 2;
+  while (pos + 4 <= len) {
+    if (data[pos] != 0xFF) {
+      return false;
+    }
+    uint8_t marker = data[pos + 1];
+    if (marker == 0xFF) { // Заполнитель перед маркером
+      pos++;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) { // Маркеры без длины
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xDA || marker == 0xD9) { // Начались данные изображения, SOF не найден
+      return false;
+    }
+
+    uint16_t seg_len = (data[pos + 2] << 8) | data[pos + 3];
+    // SOF0..SOF15, кроме DHT (C4), JPG (C8) и DAC (CC)
+    bool is_sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+    if (is_sof) {
+      if (pos + 9 > len) {
+        return false;
+      }
+      *height = (data[pos + 5] << 8) | data[pos + 6];
+      *width = (data[pos + 7] << 8) | data[pos + 8];
+      return *width > 0 && *height > 0;
+    }
+    pos += 2 + seg_len;
+  }
+  return false;
+}
@@ -11,8 +11,28 @@ struct AviIndexEntry {
   uint32_t size;
 };
 
+// Один MJPEG поток, записываемый в AVI файл
+struct AviWriter {
+  File file;
+  char path[32];
+  uint8_t header[avi_header_size];
+  AviIndexEntry* idx = nullptr; // Буфер индекса предоставляет вызывающий (см. MemoryPool)
+  size_t idx_capacity = 0;
+  uint32_t movi_offset = 4; // Начинаем после тега "movi"
+  int frames = 0;
+  int frames_size = 0;
+  int width = 0;            // Берется из первого кадра (см. jpeg_get_dimensions)
+  int height = 0;
+};
+
 void print_quartet(unsigned long i, File &fd);
 void write_avi_header(File &fd, uint8_t* buf, int frames, int width, int height, int fps, int frames_size);
 void prepare_avi_header_buffer(uint8_t* buf, int width, int height, int fps);
 
+bool avi_open(AviWriter &w, fs::FS &fs, const char* path, int fps, AviIndexEntry* idx, size_t idxCapacity);
+bool avi_write_frame(AviWriter &w, const uint8_t* data, size_t len);
+void avi_close(AviWriter &w, int fps);
+
+bool jpeg_get_dimensions(const uint8_t* data, size_t len, int* width, int* height);
+
 #endif
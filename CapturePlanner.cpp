@@ -0,0 +1,162 @@
+#include "CapturePlanner.h"
+#include "Config.h"
+#include "Uploader.h"
+#include "ProxyEncoder.h"
+#include <WiFi.h>
+#include <math.h>
+
+// Модель размера: байт на пиксель отправляемого кадра при качестве DEFAULT_JPEG_QUALITY
+// (для прокси - при PROXY_JPEG_QUALITY). Начальное значение - типичное для OV2640,
+// дальше уточняется по каждому клипу. [0] - полный поток, [1] - прокси
+static float bytesPerPixel[2] = { 0.15f, 0.15f };
+static CapturePlan lastPlan;
+
+// Разрешения, между которыми выбирает планировщик (от большего к меньшему)
+static const framesize_t frameSizeLadder[] = {
+  FRAMESIZE_UXGA, FRAMESIZE_SXGA, FRAMESIZE_XGA, FRAMESIZE_SVGA,
+  FRAMESIZE_VGA, FRAMESIZE_CIF, FRAMESIZE_QVGA
+};
+
+static const char* frameSizeName(framesize_t fs) {
+  switch (fs) {
+    case FRAMESIZE_UXGA: return "UXGA";
+    case FRAMESIZE_SXGA: return "SXGA";
+    case FRAMESIZE_XGA:  return "XGA";
+    case FRAMESIZE_SVGA: return "SVGA";
+    case FRAMESIZE_VGA:  return "VGA";
+    case FRAMESIZE_CIF:  return "CIF";
+    case FRAMESIZE_QVGA: return "QVGA";
+    default:             return "?";
+  }
+}
+
+// Относительный размер JPEG от качества сенсора (10-63, меньше = лучше): примерно 1/q
+static float qualityFactor(int quality) {
+  return (float)DEFAULT_JPEG_QUALITY / quality;
+}
+
+// Пикселей в секунду в отправляемом файле (с учетом прокси)
+static float uploadPixelsPerSec(float pixels, int fps, bool proxy) {
+  if (proxy) {
+    int div = proxyScaleDivider(PROXY_SCALE);
+    return pixels / (div * div) * ((float)fps / PROXY_FRAME_DIVIDER);
+  }
+  return pixels * fps;
+}
+
+// Ожидаемая скорость с поправкой на текущий сигнал:
+// каждые ~6 дБ хуже, чем при замерах, примерно вдвое снижают скорость WiFi
+static float expectedRate() {
+  const LinkEstimate &link = linkEstimate();
+  float drop = link.rssi - WiFi.RSSI();
+  float factor = drop > 0 ? powf(2.0f, -drop / 6.0f) : 1.0f;
+  return link.bytesPerSec * factor;
+}
+
+// Выбор параметров клипа: из всех вариантов (разрешение x FPS x качество) берется
+// самый "богатый" по объему, который отправляется не дольше UPLOAD_BUDGET_FRACTION
+// от длительности клипа. Качество подбирается только без прокси: прокси
+// перекодируется с фиксированным PROXY_JPEG_QUALITY. С ROI окно сенсора
+// выбрано пользователем, поэтому меняются только FPS и качество.
+// proxy - будет ли записан прокси (его нет без PSRAM или при нехватке памяти).
+CapturePlan planCapture(int recordDuration, int fps, int jpegQuality, framesize_t maxFrameSize,
+                        const RoiWindow &roi, bool proxy) {
+  bool roiActive = roi.enabled && roi.outWidth > 0;
+  CapturePlan plan;
+  plan.proxy = proxy;
+  plan.fps = fps;
+  plan.frameSize = maxFrameSize;
+  plan.roi = roiActive;
+  plan.width = roiActive ? roi.outWidth : resolution[maxFrameSize].width;
+  plan.height = roiActive ? roi.outHeight : resolution[maxFrameSize].height;
+  plan.jpegQuality = jpegQuality;
+  plan.budgetSec = recordDuration * UPLOAD_BUDGET_FRACTION;
+
+  if (linkEstimate().samples == 0) {
+    lastPlan = plan; // Замеров нет - пишем по настройкам пользователя
+    return plan;
+  }
+  plan.measured = true;
+  // После одних неудачных отправок оценка может быть нулевой - тогда берется самый легкий вариант
+  float rate = expectedRate();
+  if (rate < 1) rate = 1;
+
+  const int qualitySteps[] = { 0, 8, 16, 28 };
+  int qualityCount = proxy ? 1 : 4;
+  bool found = false;
+  CapturePlan cheapest;
+
+  int sizeCount = roiActive ? 1 : sizeof(frameSizeLadder) / sizeof(frameSizeLadder[0]);
+
+  for (int si = 0; si < sizeCount; si++) {
+    framesize_t fs = roiActive ? maxFrameSize : frameSizeLadder[si];
+    if (fs > maxFrameSize) continue; // Буферы камеры выделены под maxFrameSize
+    int width = roiActive ? roi.outWidth : resolution[fs].width;
+    int height = roiActive ? roi.outHeight : resolution[fs].height;
+    for (int f = fps; f >= PLAN_MIN_FPS; f -= 5) {
+      for (int qi = 0; qi < qualityCount; qi++) {
+        CapturePlan c = plan;
+        c.frameSize = fs;
+        c.width = width;
+        c.height = height;
+        c.fps = f;
+        c.jpegQuality = constrain(jpegQuality + qualitySteps[qi], 10, 63);
+        float qf = proxy ? 1.0f : qualityFactor(c.jpegQuality);
+        c.expectedBytes = bytesPerPixel[proxy] * qf * uploadPixelsPerSec((float)width * height, f, proxy) * recordDuration;
+        c.expectedUploadSec = c.expectedBytes / rate;
+
+        if (c.expectedUploadSec <= plan.budgetSec && (!found || c.expectedBytes > plan.expectedBytes)) {
+          plan = c;
+          found = true;
+        }
+        if (cheapest.expectedBytes == 0 || c.expectedBytes < cheapest.expectedBytes) {
+          cheapest = c;
+        }
+      }
+    }
+  }
+
+  if (!found) {
+    plan = cheapest;
+    plan.limited = true;
+  }
+  lastPlan = plan;
+  return plan;
+}
+
+// Настройка сенсора под план (только если что-то поменялось).
+// С ROI размер не трогаем: set_framesize сбросил бы окно сенсора
+void applyCapturePlan(const CapturePlan &plan) {
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) return;
+  if (!plan.roi && s->status.framesize != plan.frameSize) s->set_framesize(s, plan.frameSize);
+  if (s->status.quality != plan.jpegQuality) s->set_quality(s, plan.jpegQuality);
+}
+
+// Уточнение модели по фактическому размеру отправляемого файла.
+// proxy - отправлялся ли прокси на самом деле (мог не открыться, см. recordVideo)
+void captureModelUpdate(const CapturePlan &plan, uint32_t uploadBytes, double uploadPixels, bool proxy) {
+  if (uploadBytes == 0 || uploadPixels <= 0) return;
+  float qf = proxy ? 1.0f : qualityFactor(plan.jpegQuality);
+  float measured = uploadBytes / uploadPixels / qf;
+  bytesPerPixel[proxy] += 0.5f * (measured - bytesPerPixel[proxy]);
+}
+
+// Оценка канала и последнее решение планировщика для /status
+int formatCaptureStatus(char* out, size_t cap) {
+  const LinkEstimate &link = linkEstimate();
+  if (link.samples == 0) {
+    return snprintf(out, cap, "Канал: нет замеров\nПлан: по настройкам");
+  }
+  int len = snprintf(out, cap, "Канал: %.0f КБ/с, RSSI %.0f дБм (замеров %d)\n",
+                     link.bytesPerSec / 1024, link.rssi, link.samples);
+  if (!lastPlan.measured) {
+    return len + snprintf(out + len, cap - len, "План: по настройкам (до следующего клипа)");
+  }
+  return len + snprintf(out + len, cap - len,
+    "План: %s %dx%d %d fps q%d, отправка ~%.0f с из %.0f с%s",
+    lastPlan.roi ? "ROI" : frameSizeName(lastPlan.frameSize), lastPlan.width, lastPlan.height,
+    lastPlan.fps, lastPlan.jpegQuality,
+    lastPlan.expectedUploadSec, lastPlan.budgetSec,
+    lastPlan.limited ? " (канал слишком медленный)" : "");
+}
@@ -0,0 +1,30 @@
+#ifndef CAPTURE_PLANNER_H
+#define CAPTURE_PLANNER_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "SensorWindow.h"
+
+// Параметры следующего клипа, подобранные под скорость канала
+struct CapturePlan {
+  int fps = 0;
+  framesize_t frameSize = FRAMESIZE_INVALID;
+  bool roi = false;             // true - окно сенсора задано ROI, frameSize не применяется
+  bool proxy = false;           // true - отправляется прокси, а не полный файл
+  int width = 0;                // Размер кадра сенсора
+  int height = 0;
+  int jpegQuality = 0;
+  float expectedBytes = 0;      // Ожидаемый размер отправляемого файла
+  float expectedUploadSec = 0;  // Ожидаемое время его отправки
+  float budgetSec = 0;          // Допустимое время отправки (доля длительности клипа)
+  bool measured = false;        // false - замеров канала еще нет, взяты настройки пользователя
+  bool limited = false;         // true - даже самый легкий вариант не укладывается в бюджет
+};
+
+CapturePlan planCapture(int recordDuration, int fps, int jpegQuality, framesize_t maxFrameSize,
+                        const RoiWindow &roi, bool proxy);
+void applyCapturePlan(const CapturePlan &plan);
+void captureModelUpdate(const CapturePlan &plan, uint32_t uploadBytes, double uploadPixels, bool proxy);
+int formatCaptureStatus(char* out, size_t cap);
+
+#endif
@@ -0,0 +1,78 @@
+#include "ClipCatalog.h"
+#include "SD_MMC.h"
+
+int catalogCount() {
+  File f = SD_MMC.open(CATALOG_PATH, FILE_READ);
+  if (!f) return 0;
+  int count = f.size() / sizeof(ClipRecord);
+  f.close();
+  return count;
+}
+
+// Добавление записи в конец каталога. Возвращает ее номер (-1 при ошибке SD)
+int catalogAdd(const ClipRecord &rec) {
+  int index = catalogCount();
+  File f = SD_MMC.open(CATALOG_PATH, FILE_APPEND);
+  if (!f) return -1;
+  size_t written = f.write((const uint8_t*)&rec, sizeof(rec));
+  f.close();
+  return written == sizeof(rec) ? index : -1;
+}
+
+// Перезапись существующей записи (например, когда появился file_id)
+bool catalogUpdate(int index, const ClipRecord &rec) {
+  if (index < 0 || index >= catalogCount()) return false;
+  File f = SD_MMC.open(CATALOG_PATH, "r+");
+  if (!f) return false;
+  bool ok = f.seek(index * sizeof(ClipRecord)) && f.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec);
+  f.close();
+  return ok;
+}
+
+static bool readRecord(File &f, int index, ClipRecord &rec) {
+  if (index < 0 || !f.seek(index * sizeof(ClipRecord))) return false;
+  if (f.read((uint8_t*)&rec, sizeof(rec)) != sizeof(rec)) return false;
+  // Защита от поврежденной записи
+  rec.path[sizeof(rec.path) - 1] = 0;
+  rec.kind[sizeof(rec.kind) - 1] = 0;
+  rec.fileId[sizeof(rec.fileId) - 1] = 0;
+  return true;
+}
+
+bool catalogGet(int index, ClipRecord &rec) {
+  File f = SD_MMC.open(CATALOG_PATH, FILE_READ);
+  if (!f) return false;
+  bool ok = readRecord(f, index, rec);
+  f.close();
+  return ok;
+}
+
+// Последние maxItems клипов для /clips (новые сверху)
+int formatCatalog(char* out, size_t cap, int maxItems) {
+  File f = SD_MMC.open(CATALOG_PATH, FILE_READ);
+  int count = f ? f.size() / sizeof(ClipRecord) : 0;
+  if (count == 0) {
+    if (f) f.close();
+    return snprintf(out, cap, "Каталог пуст");
+  }
+
+  size_t len = 0;
+  for (int i = count - 1; i >= 0 && i >= count - maxItems && len + 1 < cap; i--) {
+    ClipRecord rec;
+    if (!readRecord(f, i, rec)) break;
+    const char* name = strrchr(rec.path, '/');
+    name = name ? name + 1 : rec.path;
+    // ✅ - есть file_id (пересылка без загрузки), 📁 - только на SD, ❌ - удален и не загружен
+    const char* state = rec.fileId[0] ? "✅" : (SD_MMC.exists(rec.path) ? "📁" : "❌");
+    int n = snprintf(out + len, cap - len, "%s #%d %s %.2f MB\n", state, i + 1, name, rec.size / 1024.0 / 1024.0);
+    if (n < 0) break;
+    len = (len + n >= cap) ? cap - 1 : len + n;
+  }
+  f.close();
+
+  if (len + 1 < cap) {
+    int n = snprintf(out + len, cap - len, "Всего: %d. Переслать: /send <номер>", count);
+    if (n > 0) len = (len + n >= cap) ? cap - 1 : len + n;
+  }
+  return len;
+}
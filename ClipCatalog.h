@@ -0,0 +1,23 @@
+#ifndef CLIP_CATALOG_H
+#define CLIP_CATALOG_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Запись каталога: отправленный клип и его file_id в Telegram.
+// Каталог - файл CATALOG_PATH из записей фиксированного размера,
+// номер клипа = номер записи + 1 (не меняется при добавлении новых).
+struct ClipRecord {
+  char path[32] = "";          // Файл на SD (может быть уже удален при нехватке места)
+  uint32_t size = 0;
+  char kind[12] = "";          // Тип медиа в ответе Telegram: video, animation, document
+  char fileId[FILE_ID_MAX] = ""; // Пусто, если файл еще не загружен
+};
+
+int catalogAdd(const ClipRecord &rec);
+bool catalogUpdate(int index, const ClipRecord &rec);
+bool catalogGet(int index, ClipRecord &rec);
+int catalogCount();
+int formatCatalog(char* out, size_t cap, int maxItems);
+
+#endif
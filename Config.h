@@ -31,16 +31,84 @@
 #define DEFAULT_RECORD_DURATION 300 // Длительность записи в секундах (300с = 5 мин)
 #define DEFAULT_FPS 10              // Кадров в секунду (рекомендуется 10-25)
 #define DEFAULT_JPEG_QUALITY 12     // Качество JPEG (10-63, меньше = лучше, но больше файл)
-#define DEFAULT_FRAME_SIZE FRAMESIZE_QVGA // Разрешение (QVGA=320x240, VGA=640x480)
+#define DEFAULT_FRAME_SIZE FRAMESIZE_VGA // Разрешение (QVGA=320x240, VGA=640x480)
 #define MAX_FILE_SIZE_MB 45         // Макс размер файла (Telegram лимит 50MB)
 #define DEFAULT_FLASH_BRIGHTNESS 0  // Яркость вспышки при старте (0-255)
 #define FLASH_LEDC_CHANNEL 2        // Канал PWM для вспышки
 #define FLASH_LEDC_FREQ 5000        // Частота PWM
 #define FLASH_LEDC_RES 8            // Разрешение PWM
 
+// ==========================================
+// ПРОКСИ-ПОТОК (уменьшенная копия для отправки)
+// ==========================================
+#define PROXY_ENABLED 1             // 1 = писать рядом с основным файлом уменьшенную копию
+#define PROXY_SCALE JPG_SCALE_2X    // Уменьшение: JPG_SCALE_2X (1/2) или JPG_SCALE_4X (1/4)
+#define PROXY_JPEG_QUALITY 60       // Качество прокси (0-100, больше = лучше)
+#define PROXY_FRAME_DIVIDER 2       // В прокси попадает каждый N-й кадр (экономия CPU)
+#define PROXY_SLOTS 2               // Копий кадров в очереди кодировщика прокси (ядро 0)
+#define MIN_FREE_SPACE_MB 200       // Удалять старые записи, если на SD меньше места
+
+// ==========================================
+// ЗАГРУЗКА И ПОДКЛЮЧЕНИЕ WIFI
+// ==========================================
+#define BOOT_POWER_SETTLE_MS 100          // Пауза для стабилизации питания при старте
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 4000 // Попытка по сохраненным BSSID/каналу, затем полный поиск
+#define WIFI_CONNECT_TIMEOUT_MS 20000     // Без подключения (и без записи) -> Captive Portal
+
+// ==========================================
+// ПАМЯТЬ (арены выделяются один раз при старте)
+// ==========================================
+#define REC_ARENA_SIZE (1024 * 1024) // PSRAM: индексы AVI (8 байт/кадр) и буферы прокси
+#define REC_ARENA_FALLBACK_SIZE (32 * 1024) // Без PSRAM: только индекс AVI (~4000 кадров), без прокси
+#define NET_ARENA_SIZE (36 * 1024)   // Внутренняя DMA память: кольцо буферов отправки и ответ сервера
+#define LOG_MSG_MAX 512              // Макс. длина сообщения лога/ответа бота
+#define STATUS_MSG_MAX 1024          // Макс. длина ответа на /status
+
+// ==========================================
+// ОТПРАВКА ВИДЕО (конвейер SD -> TLS)
+// ==========================================
+#define UPLOAD_RING_BUFFERS 4           // Буферов в кольце упреждающего чтения SD
+#define UPLOAD_BUFFER_SIZE (8 * 1024)   // Размер одного буфера (макс. чанк)
+#define UPLOAD_CHUNK_MIN 1024           // Мин. чанк на медленном канале
+#define UPLOAD_CHUNK_START 4096         // Начальный чанк до первого замера
+#define UPLOAD_CHUNK_TARGET_MS 250      // Чанк подбирается так, чтобы отправка занимала ~столько
+#define UPLOAD_STALL_TIMEOUT_MS 10000   // Тайм-аут ожидания данных от SD
+#define HTTP_RESPONSE_TIMEOUT_MS 20000  // Тайм-аут ответа сервера
+#define HTTP_BODY_MAX 2048              // Макс. сохраняемый размер тела ответа
+
+// ==========================================
+// ПЛАНИРОВАНИЕ ЗАПИСИ ПОД СКОРОСТЬ КАНАЛА
+// ==========================================
+#define UPLOAD_BUDGET_FRACTION 0.5      // Отправка клипа должна занимать не больше этой доли его длительности
+#define LINK_EWMA_ALPHA 0.3f            // Вес нового замера скорости в скользящей оценке
+#define PLAN_MIN_FPS 5                  // Ниже этого FPS планировщик не опускается
+
+// ==========================================
+// ОБЛАСТЬ ИНТЕРЕСА (ROI)
+// ==========================================
+#define ROI_MIN_PERCENT 10              // Минимальная ширина/высота окна ROI в процентах кадра
+
+// ==========================================
+// ПОЛУЧАТЕЛИ И КАТАЛОГ ЗАПИСЕЙ
+// ==========================================
+#define MAX_RECIPIENTS 8                // Макс. число чатов, куда рассылаются клипы
+#define CHAT_ID_MAX 32                  // Макс. длина ID чата ("-100..." или "@channel")
+#define FILE_ID_MAX 128                 // Макс. длина file_id Telegram
+#define CATALOG_PATH "/clips.bin"       // Каталог отправленных клипов на SD (с file_id)
+#define CATALOG_LIST_MAX 10             // Сколько последних клипов показывает /clips
+
 // ==========================================
 // УЧЕТНЫЕ ДАННЫЕ
 // ==========================================
 // Токен вашего Telegram бота (получите у @BotFather)
 #define BOT_TOKEN "8061703653:AAF0D_mH6VgStlPhcDDvX0sWpU-ShGnifzw"
+
+// Адрес Bot API для отправки видео. Можно переопределить при сборке
+// (например, для локальной заглушки из bench/, см. bench/README.md)
+#ifndef TELEGRAM_API_HOST
+#define TELEGRAM_API_HOST "api.telegram.org"
+#endif
+#ifndef TELEGRAM_API_PORT
+#define TELEGRAM_API_PORT 443
+#endif
 #endif
@@ -19,6 +19,9 @@
 #include "WifiManager.h"
 #include "TelegramManager.h"
 #include "VideoRecorder.h"
+#include "MemoryPool.h"
+#include "CapturePlanner.h"
+#include "SensorWindow.h"
 
 // ==========================================
 // ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ И НАСТРОЙКИ
@@ -34,6 +37,7 @@ int fps = DEFAULT_FPS;
 int jpegQuality = DEFAULT_JPEG_QUALITY;
 framesize_t frameSize = DEFAULT_FRAME_SIZE;
 int flashBrightness = DEFAULT_FLASH_BRIGHTNESS;
+RoiWindow roi; // Область интереса (окно сенсора)
 
 // Состояние
 bool isRecordingActive = false; // Активна ли циклическая запись
@@ -45,8 +49,9 @@ Preferences preferences; // Объект для сохранения настр
 // НАСТРОЙКА (SETUP)
 // ==========================================
 void setup() {
-  // Задержка для стабилизации питания при старте
-  delay(2000);
+  // Короткая пауза для стабилизации питания при старте
+  // (каждая секунда загрузки - это секунда без записи после сбоя питания)
+  delay(BOOT_POWER_SETTLE_MS);
 
   Serial.begin(115200);
   Serial.println("\n\n--- ESP32-CAM Video Recorder Запуск ---");
@@ -70,10 +75,14 @@ void setup() {
   // Загрузка ID чата и параметров записи
   chatId = preferences.getString("chatId", "");
   if (chatId != "") Serial.println("Загружен ChatID: " + chatId);
+  loadRecipients(preferences); // Дополнительные чаты для рассылки клипов
   
   recordDuration = preferences.getInt("duration", DEFAULT_RECORD_DURATION);
   fps = preferences.getInt("fps", DEFAULT_FPS);
   flashBrightness = preferences.getInt("flash", DEFAULT_FLASH_BRIGHTNESS);
+  roiLoad(preferences, roi);
+  // Если запись шла до перезагрузки (сбой питания, watchdog), продолжаем сразу
+  isRecordingActive = preferences.getBool("recording", false);
   
   // 2. Инициализация SD карты
   Serial.println("Инициализация SD карты...");
@@ -115,6 +124,14 @@ void setup() {
     return;
   }
   Serial.printf("Размер SD карты: %lluMB\n", SD_MMC.cardSize() / (1024 * 1024));
+  recorderBegin(preferences); // Сквозная нумерация записей
+  
+  // WiFi подключается в фоне, параллельно с инициализацией камеры и записью
+  if (ssid == "") {
+    Serial.println("Нет сохраненных настроек WiFi. Запуск режима точки доступа (Captive Portal)...");
+    startCaptivePortal(preferences); // Это заблокирует выполнение до сохранения настроек
+  }
+  wifiBeginFast(preferences, ssid, password);
   
   // 3. Инициализация Камеры
   camera_config_t config;
@@ -156,54 +173,18 @@ void setup() {
     Serial.printf("Ошибка инициализации камеры: 0x%x", err);
     return;
   }
-  
-  // 4. Подключение к WiFi
-  if (ssid == "") {
-    Serial.println("Нет сохраненных настроек WiFi. Запуск режима точки доступа (Captive Portal)...");
-    startCaptivePortal(preferences); // Это заблокирует выполнение до сохранения настроек
-  }
 
-  Serial.printf("Подключение к WiFi: %s...\n", ssid.c_str());
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), password.c_str());
-  
-  unsigned long startAttempt = millis();
-  bool wifiConnected = false;
-  // Ждем подключения 20 секунд
-  while(millis() - startAttempt < 20000) { 
-    if (WiFi.status() == WL_CONNECTED) {
-      wifiConnected = true;
-      break;
-    }
-    delay(500);
-    Serial.print(".");
-  }
+  // Арены памяти выделяются один раз, после буферов камеры
+  initMemoryPools();
   
-  if (wifiConnected) {
-    Serial.println("\nWiFi подключен успешно");
-    Serial.print("IP адрес: ");
-    Serial.println(WiFi.localIP());
-    
-    // Настройка безопасного клиента для Telegram (без проверки сертификата)
-    client.setInsecure();
-    client.setHandshakeTimeout(30000); // Тайм-аут рукопожатия 30 сек
-    
-    // Ждем немного для стабилизации сети
-    delay(2000);
-    
-    // Настройка PWM для фонарика
-    // ESP32 Arduino Core v3.0+ использует ledcAttach(pin, freq, res)
-    ledcAttach(FLASH_GPIO_NUM, FLASH_LEDC_FREQ, FLASH_LEDC_RES);
-    ledcWrite(FLASH_GPIO_NUM, flashBrightness);
-
-    // Отправка приветственного сообщения
-    logToBot("Бот запущен. Готов к работе.");
-    if (chatId == "") {
-      Serial.println("ChatID не установлен. Отправьте /start боту.");
-    }
-  } else {
-    Serial.println("\nНе удалось подключиться к WiFi. Запуск режима настройки (Captive Portal)...");
-    startCaptivePortal(preferences); // Запуск точки доступа для ввода новых данных
+  // Настройка PWM для фонарика
+  // ESP32 Arduino Core v3.0+ использует ledcAttach(pin, freq, res)
+  ledcAttach(FLASH_GPIO_NUM, FLASH_LEDC_FREQ, FLASH_LEDC_RES);
+  ledcWrite(FLASH_GPIO_NUM, flashBrightness);
+
+  Serial.printf("Камера готова через %lu мс после старта\n", millis());
+  if (isRecordingActive) {
+    Serial.println("Продолжаем запись, начатую до перезагрузки");
   }
 }
 
@@ -212,6 +193,14 @@ void setup() {
 // ==========================================
 void loop() {
   unsigned long now = millis();
+
+  // 0. Обслуживание WiFi (подключение идет в фоне)
+  wifiService();
+  wifiSendBootReport(); // Между клипами: отправка не прерывает запись
+  if (wifiFailed() && !isRecordingActive) {
+    Serial.println("\nНе удалось подключиться к WiFi. Запуск режима настройки (Captive Portal)...");
+    startCaptivePortal(preferences); // Запуск точки доступа для ввода новых данных
+  }
   
   // 1. Проверка команд от Бота
   if (now - lastBotCheckTime > 3000) { // Проверяем каждые 3 секунды
@@ -220,23 +209,44 @@ void loop() {
       int numNewMessages = bot.getUpdates(bot.last_message_received + 1);
       if (numNewMessages > 0) {
         // Обработка входящих сообщений
-        handleNewMessages(numNewMessages, isRecordingActive, recordDuration, fps, jpegQuality, frameSize, flashBrightness, preferences);
+        handleNewMessages(numNewMessages, isRecordingActive, recordDuration, fps, jpegQuality, frameSize, flashBrightness, roi, preferences);
       }
     }
   }
   
   // 2. Цикл записи видео
   if (isRecordingActive) {
-    // Запись видео файла
-    String savedFile = recordVideo(recordDuration, fps, ssid, password);
+    // Окно сенсора (ROI) настраивается перед каждым клипом: режим сенсора
+    // зависит от FPS, который мог поменяться через бота
+    if (roi.enabled && !roiApply(roi, frameSize, fps)) {
+      Serial.println("Не удалось применить ROI, запись полного кадра");
+    }
+
+    // Параметры клипа под измеренную скорость канала (FPS, разрешение, качество;
+    // с ROI - только FPS и качество)
+    CapturePlan plan = planCapture(recordDuration, fps, jpegQuality, frameSize, roi, recorderProxyAvailable());
+    applyCapturePlan(plan);
+    if (plan.measured) {
+      Serial.printf("План: %dx%d, %d fps, q%d, отправка ~%.0f с из %.0f с\n",
+                    plan.width, plan.height, plan.fps, plan.jpegQuality, plan.expectedUploadSec, plan.budgetSec);
+    }
+
+    // Запись видео файла (полное разрешение + прокси)
+    RecordedClip clip = recordVideo(recordDuration, plan.fps);
+    captureModelUpdate(plan, clip.uploadBytes, clip.uploadPixels, clip.proxyUsed());
     
-    if (savedFile != "") {
-      // Отправка в Telegram
-      bool sent = sendVideoToTelegram(savedFile);
+    if (clip.fullPath[0]) {
+      // Отправка в Telegram (по умолчанию только прокси): загрузка в основной чат,
+      // остальным получателям - пересылка по file_id
+      const char* uploadFile = clip.uploadPath();
+      bool sent = sendVideoToTelegram(uploadFile);
       if (sent) {
         logToBot("Видео успешно отправлено.");
-        // Удаляем файл с карты памяти после успешной отправки, чтобы не забивать место
-        SD_MMC.remove(savedFile); 
+        // Прокси после отправки не нужен. Полная запись остается на SD,
+        // старые записи удаляются в pruneOldRecordings() при нехватке места
+        if (uploadFile == clip.proxyPath) { // Сравнение указателей: отправлен именно прокси
+          SD_MMC.remove(uploadFile);
+        }
       } else {
         logToBot("Не удалось отправить видео.");
       }
@@ -0,0 +1,69 @@
+#include "MemoryPool.h"
+#include "Config.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+
+Arena recArena;
+Arena netArena;
+
+// Выделение блока памяти под арену. Если блока такого размера нет,
+// пробуем вдвое меньший - только в памяти с теми же caps.
+bool Arena::begin(const char* name, size_t capacity, uint32_t caps) {
+  _name = name;
+  _base = nullptr;
+
+  while (capacity >= 1024) {
+    _base = (uint8_t*)heap_caps_malloc(capacity, caps);
+    if (_base) break;
+    capacity /= 2;
+  }
+
+  _capacity = _base ? capacity : 0;
+  _psram = _base && esp_ptr_external_ram(_base);
+  _used = 0;
+  _highWater = 0;
+  _failures = 0;
+
+  Serial.printf("Арена %s: %u КБ (%s)\n", _name, (unsigned)(_capacity / 1024), _psram ? "PSRAM" : "внутренняя");
+  return _base != nullptr;
+}
+
+void* Arena::alloc(size_t size, size_t align) {
+  size_t start = (_used + align - 1) & ~(align - 1);
+  if (!_base || start + size > _capacity) {
+    _failures++;
+    Serial.printf("Арена %s: нет места для %u байт (занято %u из %u)\n", _name,
+                  (unsigned)size, (unsigned)_used, (unsigned)_capacity);
+    return nullptr;
+  }
+  _used = start + size;
+  if (_used > _highWater) _highWater = _used;
+  return _base + start;
+}
+
+void Arena::reset() {
+  _used = 0;
+}
+
+void initMemoryPools() {
+  if (!recArena.begin("rec", REC_ARENA_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)) {
+    // Плата без PSRAM: внутренняя куча нужна WiFi и TLS, поэтому берем
+    // небольшой фиксированный блок только под индекс AVI (прокси отключается)
+    recArena.begin("rec", REC_ARENA_FALLBACK_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  netArena.begin("net", NET_ARENA_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+}
+
+// Статистика арен и внутренней кучи для /status
+int formatMemoryStats(char* out, size_t cap) {
+  return snprintf(out, cap,
+    "Память rec: %u/%u КБ (пик %u, отказов %u)\n"
+    "Память net: %u/%u КБ (пик %u, отказов %u)\n"
+    "Куча: свободно %u КБ, макс. блок %u КБ",
+    (unsigned)(recArena.used() / 1024), (unsigned)(recArena.capacity() / 1024),
+    (unsigned)(recArena.highWater() / 1024), (unsigned)recArena.failures(),
+    (unsigned)(netArena.used() / 1024), (unsigned)(netArena.capacity() / 1024),
+    (unsigned)(netArena.highWater() / 1024), (unsigned)netArena.failures(),
+    (unsigned)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
+    (unsigned)(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) / 1024));
+}
@@ -0,0 +1,43 @@
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <Arduino.h>
+
+// Арена с линейным выделением памяти (bump allocator).
+// Память берется из кучи один раз при старте и больше не освобождается,
+// поэтому циклы запись/отправка не фрагментируют внутреннюю кучу.
+// Отдельные блоки не освобождаются - арена целиком сбрасывается через reset().
+class Arena {
+ public:
+  bool begin(const char* name, size_t capacity, uint32_t caps);
+  void* alloc(size_t size, size_t align = 4);
+  void reset();
+
+  template <typename T>
+  T* allocArray(size_t count) { return (T*)alloc(count * sizeof(T), alignof(T)); }
+
+  const char* name() const { return _name; }
+  size_t capacity() const { return _capacity; }
+  size_t used() const { return _used; }
+  size_t available() const { return _capacity - _used; }
+  size_t highWater() const { return _highWater; }
+  uint32_t failures() const { return _failures; }
+  bool inPsram() const { return _psram; }
+
+ private:
+  const char* _name = "";
+  uint8_t* _base = nullptr;
+  size_t _capacity = 0;
+  size_t _used = 0;
+  size_t _highWater = 0;
+  uint32_t _failures = 0;
+  bool _psram = false;
+};
+
+extern Arena recArena;  // PSRAM: индексы AVI и буферы прокси, сбрасывается перед каждой записью
+extern Arena netArena;  // Внутренняя DMA память: буферы чтения SD для отправки
+
+void initMemoryPools();
+int formatMemoryStats(char* out, size_t cap);
+
+#endif
@@ -0,0 +1,172 @@
+#include "ProxyEncoder.h"
+#include "Config.h"
+#include "MemoryPool.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+// Кодирование прокси идет в отдельной задаче на ядре 0, чтобы не снижать
+// частоту основного потока: цикл записи только копирует кадр в свободный слот
+// и сразу возвращает буфер камеры. Слот с len == 0 - сигнал завершения.
+struct ProxySlot {
+  uint8_t* buf;
+  size_t len;
+};
+
+// Внутреннее состояние кодировщика (один прокси-поток за раз)
+// Буферы берутся из recArena и живут до ее сброса перед следующей записью
+static uint8_t* rgbBuf = nullptr;
+static uint8_t* jpgBuf = nullptr;
+static size_t jpgCap = 0;
+static size_t jpgLen = 0;
+static size_t slotCap = 0;
+static jpg_scale_t proxyScale = JPG_SCALE_2X;
+static int proxyQuality = 60;
+static ProxyStats stats;
+
+static QueueHandle_t freeQueue = nullptr;  // Пустые слоты -> цикл записи
+static QueueHandle_t fullQueue = nullptr;  // Кадры на уменьшение -> задача кодирования
+static SemaphoreHandle_t encoderDone = nullptr;
+static AviWriter* proxyOut = nullptr;
+static bool encoderRunning = false;
+
+// Приемник выхода JPEG кодировщика: пишем в заранее выделенный буфер без malloc на кадр
+static size_t jpgOut(void* arg, size_t index, const void* data, size_t len) {
+  if (index + len > jpgCap) {
+    return 0; // Кадр не поместился - кодировщик прервет работу
+  }
+  memcpy(jpgBuf + index, data, len);
+  jpgLen = index + len;
+  return len;
+}
+
+// Уменьшение одного JPEG кадра в jpgBuf
+// Уменьшение происходит прямо при декодировании: декодер отбрасывает
+// высокочастотные коэффициенты DCT, поэтому полный кадр в память не разворачивается.
+static bool encodeFrame(const uint8_t* jpg, size_t len) {
+  unsigned long t0 = micros();
+
+  if (!jpg2rgb565(jpg, len, rgbBuf, proxyScale)) {
+    return false;
+  }
+  jpgLen = 0;
+  if (!fmt2jpg_cb(rgbBuf, stats.width * stats.height * 2, stats.width, stats.height,
+                  PIXFORMAT_RGB565, proxyQuality, jpgOut, nullptr)) {
+    return false;
+  }
+
+  stats.encodeMicros += micros() - t0;
+  stats.frames++;
+  stats.sourceBytes += len;
+  stats.proxyBytes += jpgLen;
+  return true;
+}
+
+// Прокси-файл пишется только этой задачей (FatFs в ESP-IDF допускает работу
+// с разными файлами из разных задач)
+static void encoderTask(void* arg) {
+  ProxySlot slot;
+  while (xQueueReceive(fullQueue, &slot, portMAX_DELAY) == pdTRUE) {
+    if (slot.len == 0) break;
+    if (encodeFrame(slot.buf, slot.len)) {
+      avi_write_frame(*proxyOut, jpgBuf, jpgLen);
+    }
+    xQueueSend(freeQueue, &slot, 0);
+  }
+  xSemaphoreGive(encoderDone);
+  vTaskDelete(NULL);
+}
+
+// Подготовка буферов и запуск задачи кодирования. out - уже открытый
+// прокси-файл, в него же записывается размер уменьшенного кадра
+bool proxyBegin(int srcWidth, int srcHeight, jpg_scale_t scale, int quality, AviWriter &out) {
+  proxyEnd();
+
+  int div = proxyScaleDivider(scale);
+  stats = ProxyStats();
+  stats.width = srcWidth / div;
+  stats.height = srcHeight / div;
+  proxyScale = scale;
+  proxyQuality = quality;
+
+  if (stats.width == 0 || stats.height == 0) return false;
+
+  if (!freeQueue) {
+    freeQueue = xQueueCreate(PROXY_SLOTS, sizeof(ProxySlot));
+    fullQueue = xQueueCreate(PROXY_SLOTS + 1, sizeof(ProxySlot)); // + сигнал завершения
+    encoderDone = xSemaphoreCreateBinary();
+  }
+  if (!freeQueue || !fullQueue || !encoderDone) return false;
+  xQueueReset(freeQueue);
+  xQueueReset(fullQueue);
+  xSemaphoreTake(encoderDone, 0);
+
+  // RGB565 кадр (до 150 КБ) и выходной JPEG (не больше 1 байта на пиксель)
+  rgbBuf = recArena.allocArray<uint8_t>(stats.width * stats.height * 2);
+  jpgCap = stats.width * stats.height;
+  jpgBuf = recArena.allocArray<uint8_t>(jpgCap);
+  if (!rgbBuf || !jpgBuf) {
+    proxyEnd();
+    return false;
+  }
+
+  // Слоты под исходные кадры: камера выделяет под JPEG кадр ширина * высота / 5
+  slotCap = srcWidth * srcHeight / 5;
+  for (int i = 0; i < PROXY_SLOTS; i++) {
+    ProxySlot slot = { recArena.allocArray<uint8_t>(slotCap), 0 };
+    if (!slot.buf) {
+      if (i == 0) {
+        proxyEnd();
+        return false;
+      }
+      break; // Работаем с тем, что есть
+    }
+    xQueueSend(freeQueue, &slot, 0);
+  }
+
+  out.width = stats.width;
+  out.height = stats.height;
+  proxyOut = &out;
+  if (xTaskCreatePinnedToCore(encoderTask, "proxy_enc", 8192, nullptr, 1, nullptr, 0) != pdPASS) {
+    proxyEnd();
+    return false;
+  }
+  encoderRunning = true;
+  return true;
+}
+
+// Передача кадра кодировщику без ожидания. Если все слоты заняты,
+// кадр в прокси не попадает (учитывается в stats.dropped)
+bool proxySubmit(const uint8_t* jpg, size_t len) {
+  ProxySlot slot;
+  if (!encoderRunning || len == 0 || len > slotCap ||
+      xQueueReceive(freeQueue, &slot, 0) != pdTRUE) {
+    stats.dropped++;
+    return false;
+  }
+  memcpy(slot.buf, jpg, len);
+  slot.len = len;
+  xQueueSend(fullQueue, &slot, 0);
+  return true;
+}
+
+// Ожидание кадров, уже переданных кодировщику, и остановка задачи.
+// После возврата прокси-файл можно закрывать, stats окончательные.
+// Буферы принадлежат recArena, здесь только забываем о них
+void proxyEnd() {
+  if (encoderRunning) {
+    ProxySlot stop = { nullptr, 0 };
+    xQueueSend(fullQueue, &stop, portMAX_DELAY);
+    xSemaphoreTake(encoderDone, portMAX_DELAY);
+    encoderRunning = false;
+  }
+  proxyOut = nullptr;
+  rgbBuf = nullptr;
+  jpgBuf = nullptr;
+  jpgCap = 0;
+  slotCap = 0;
+}
+
+const ProxyStats& proxyStats() {
+  return stats;
+}
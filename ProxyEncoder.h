@@ -0,0 +1,34 @@
+#ifndef PROXY_ENCODER_H
+#define PROXY_ENCODER_H
+
+#include <Arduino.h>
+#include "img_converters.h"
+#include "AviUtils.h"
+
+// Статистика прокси-потока за один клип
+struct ProxyStats {
+  int width = 0;
+  int height = 0;
+  int frames = 0;
+  int dropped = 0;            // Кадры, пропущенные из-за занятого кодировщика
+  uint32_t encodeMicros = 0;  // Суммарное время CPU на уменьшение кадров
+  uint32_t sourceBytes = 0;   // Размер исходных кадров, попавших в прокси
+  uint32_t proxyBytes = 0;    // Размер полученных кадров
+};
+
+// Во сколько раз прокси меньше исходного кадра по каждой стороне
+inline int proxyScaleDivider(jpg_scale_t scale) {
+  switch (scale) {
+    case JPG_SCALE_2X: return 2;
+    case JPG_SCALE_4X: return 4;
+    case JPG_SCALE_8X: return 8;
+    default:           return 1;
+  }
+}
+
+bool proxyBegin(int srcWidth, int srcHeight, jpg_scale_t scale, int quality, AviWriter &out);
+bool proxySubmit(const uint8_t* jpg, size_t len);
+void proxyEnd();
+const ProxyStats& proxyStats();
+
+#endif
@@ -0,0 +1,124 @@
+#include "SensorWindow.h"
+#include "Config.h"
+
+// Режимы OV2640 (см. ov2640.c в esp32-camera): полный кадр и биннинг 2x/4x.
+// Чем меньше режим, тем быстрее сенсор отдает кадр.
+struct SensorMode {
+  int id;
+  const char* name;
+  int width;
+  int height;
+  int maxFps; // Примерно, при XCLK 20 МГц
+};
+
+static const SensorMode OV2640_MODES[] = {
+  { 2, "CIF",  400,  296,  60 },
+  { 1, "SVGA", 800,  600,  30 },
+  { 0, "UXGA", 1600, 1200, 15 },
+};
+
+static int roundDown(int v, int step) {
+  return v / step * step;
+}
+
+bool roiValid(const RoiWindow &roi) {
+  return roi.x >= 0 && roi.y >= 0 &&
+         roi.w >= ROI_MIN_PERCENT && roi.h >= ROI_MIN_PERCENT &&
+         roi.x + roi.w <= 100 && roi.y + roi.h <= 100;
+}
+
+// Настройка окна сенсора под включенный ROI (см. roiApply)
+static bool roiConfigure(sensor_t *s, RoiWindow &roi, framesize_t frameSize, int fps) {
+  // Окно задается регистрами DSP, раскладка которых есть только для OV2640
+  if (s->id.PID != OV2640_PID || !s->set_res_raw || !roiValid(roi)) return false;
+
+  // Выход - доля ROI от заданного кадра frameSize (50%x50% от VGA = 320x240):
+  // кадр уменьшается в той же пропорции, что и площадь, а детализация
+  // остается как при полном кадре. Выход кратен 16 (блок JPEG),
+  // окно сенсора - 8 (регистры в шагах по 4 и 8)
+  int outW = roundDown(resolution[frameSize].width * roi.w / 100, 16);
+  int outH = roundDown(resolution[frameSize].height * roi.h / 100, 16);
+
+  // Самый быстрый режим, в котором окно не меньше выхода (DSP только уменьшает).
+  // Если такой режим не успевает за fps, берем более быстрый и уменьшаем выход до окна
+  const SensorMode *mode = nullptr;
+  for (const SensorMode &m : OV2640_MODES) {
+    if (mode && m.maxFps < fps) break;
+    mode = &m;
+    if (roundDown(m.width * roi.w / 100, 8) >= outW && roundDown(m.height * roi.h / 100, 8) >= outH) break;
+  }
+
+  int winW = roundDown(mode->width * roi.w / 100, 8);
+  int winH = roundDown(mode->height * roi.h / 100, 8);
+  outW = roundDown(outW < winW ? outW : winW, 16);
+  outH = roundDown(outH < winH ? outH : winH, 16);
+  if (outW < 16 || outH < 16) return false;
+
+  int offX = constrain(mode->width * roi.x / 100, 0, mode->width - winW);
+  int offY = constrain(mode->height * roi.y / 100, 0, mode->height - winH);
+  // Для OV2640 первый аргумент (startX) - номер режима сенсора
+  if (s->set_res_raw(s, mode->id, 0, 0, 0, offX, offY, winW, winH, outW, outH, false, false) != 0) {
+    return false;
+  }
+  roi.outWidth = outW;
+  roi.outHeight = outH;
+  roi.sensorMode = mode->id;
+  Serial.printf("ROI: режим %s, окно %dx%d+%d+%d, выход %dx%d\n",
+                mode->name, winW, winH, offX, offY, outW, outH);
+  return true;
+}
+
+// Настройка окна сенсора. Без ROI возвращает обычный кадр frameSize.
+// frameSize - размер, под который при старте выделены буферы камеры:
+// выход окна не может быть больше него. fps - нужная частота кадров:
+// режим сенсора, который ее не тянет, выбирается только если других нет.
+// Если окно настроить не удалось, сенсор тоже возвращается к полному кадру.
+bool roiApply(RoiWindow &roi, framesize_t frameSize, int fps) {
+  roi.outWidth = 0;
+  roi.outHeight = 0;
+  roi.sensorMode = -1;
+
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) return false;
+
+  // set_framesize заново настраивает окно и масштаб сенсора целиком
+  if (!roi.enabled) return s->set_framesize(s, frameSize) == 0;
+  if (roiConfigure(s, roi, frameSize, fps)) return true;
+
+  // Иначе остается окно прошлого клипа (или частично записанные регистры),
+  // а applyCapturePlan не вызовет set_framesize: status.framesize не менялся
+  s->set_framesize(s, frameSize);
+  return false;
+}
+
+void roiLoad(Preferences &prefs, RoiWindow &roi) {
+  roi.enabled = prefs.getBool("roi", false);
+  roi.x = prefs.getInt("roi_x", 0);
+  roi.y = prefs.getInt("roi_y", 0);
+  roi.w = prefs.getInt("roi_w", 100);
+  roi.h = prefs.getInt("roi_h", 100);
+  if (!roiValid(roi)) roi.enabled = false;
+}
+
+void roiSave(Preferences &prefs, const RoiWindow &roi) {
+  prefs.putBool("roi", roi.enabled);
+  prefs.putInt("roi_x", roi.x);
+  prefs.putInt("roi_y", roi.y);
+  prefs.putInt("roi_w", roi.w);
+  prefs.putInt("roi_h", roi.h);
+}
+
+int formatRoiStatus(const RoiWindow &roi, char* out, size_t cap) {
+  if (!roi.enabled) {
+    return snprintf(out, cap, "ROI: выкл (весь кадр)");
+  }
+  const char* mode = "?";
+  for (const SensorMode &m : OV2640_MODES) {
+    if (m.id == roi.sensorMode) mode = m.name;
+  }
+  if (roi.outWidth == 0) {
+    return snprintf(out, cap, "ROI: x%d%% y%d%% %dx%d%% (сенсор не настроен)", roi.x, roi.y, roi.w, roi.h);
+  }
+  return snprintf(out, cap, "ROI: x%d%% y%d%% %dx%d%% -> %dx%d (режим %s)",
+                  roi.x, roi.y, roi.w, roi.h, roi.outWidth, roi.outHeight, mode);
+}
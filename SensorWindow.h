@@ -0,0 +1,27 @@
+#ifndef SENSOR_WINDOW_H
+#define SENSOR_WINDOW_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "esp_camera.h"
+
+// Область интереса: сенсор выдает только выбранную часть кадра
+struct RoiWindow {
+  bool enabled = false;
+  int x = 0;        // Левый верхний угол и размер окна в процентах полного кадра
+  int y = 0;
+  int w = 100;
+  int h = 100;
+  // Результат настройки сенсора (заполняет roiApply)
+  int outWidth = 0;
+  int outHeight = 0;
+  int sensorMode = -1; // Режим OV2640: 0 - UXGA, 1 - SVGA, 2 - CIF
+};
+
+bool roiValid(const RoiWindow &roi);
+bool roiApply(RoiWindow &roi, framesize_t frameSize, int fps);
+void roiLoad(Preferences &prefs, RoiWindow &roi);
+void roiSave(Preferences &prefs, const RoiWindow &roi);
+int formatRoiStatus(const RoiWindow &roi, char* out, size_t cap);
+
+#endif
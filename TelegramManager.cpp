@@ -1,15 +1,25 @@
 #include "TelegramManager.h"
 #include "Config.h"
 #include "SD_MMC.h"
+#include "MemoryPool.h"
+#include "Uploader.h"
+#include "CapturePlanner.h"
+#include "ClipCatalog.h"
 
 // Глобальные переменные
 WiFiClientSecure client;
 UniversalTelegramBot bot(BOT_TOKEN, client);
 String chatId = "";
 
-void logToBot(String msg) {
-  Serial.println("[LOG] " + msg);
-  if (chatId != "") {
+// Дополнительные получатели клипов (кроме chatId), хранятся в prefs "chats" через запятую
+static char recipients[MAX_RECIPIENTS][CHAT_ID_MAX];
+static int recipientCount = 0;
+
+void logToBot(const char* msg) {
+  Serial.print("[LOG] ");
+  Serial.println(msg);
+  // Без WiFi не тратим время на попытки отправки (например, во время быстрой загрузки)
+  if (chatId != "" && WiFi.status() == WL_CONNECTED) {
     // Механизм повторной попытки
     for (int i = 0; i < 2; i++) {
         // Гарантируем чистое состояние
@@ -29,50 +39,121 @@ void logToBot(String msg) {
   }
 }
 
-String getMainKeyboard() {
-  String json = "[";
-  json += "[\"▶️ Начать запись\", \"⏹ Остановить\"],";
-  json += "[\"⚙ Настройки\", \"ℹ️ Статус\"]";
-  json += "]";
-  return json;
+// Форматированный лог в буфер фиксированного размера (без склейки String)
+void logToBotf(const char* fmt, ...) {
+  char msg[LOG_MSG_MAX];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  logToBot(msg);
+}
+
+// Форматированный ответ в текущий чат
+static void replyf(const char* fmt, ...) {
+  char msg[LOG_MSG_MAX];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  bot.sendMessage(chatId, msg, "");
+}
+
+// Новая длина после дописывания n символов в буфер размера cap
+// (snprintf возвращает желаемую длину, даже если текст обрезан)
+static size_t appendLen(size_t len, size_t cap, int n) {
+  if (n < 0) return len;
+  return (len + n >= cap) ? cap - 1 : len + n;
+}
+
+// ID чата: число (группы и каналы - отрицательные) или @имя канала.
+// Имя канала - только [A-Za-z0-9_], как в Telegram: ID подставляется в JSON без экранирования
+static bool validChatId(const char* id) {
+  size_t n = strlen(id);
+  if (n == 0 || n >= CHAT_ID_MAX) return false;
+  if (id[0] == '@') {
+    for (size_t i = 1; i < n; i++) {
+      if (!isalnum((unsigned char)id[i]) && id[i] != '_') return false;
+    }
+    return n > 1;
+  }
+  for (size_t i = (id[0] == '-') ? 1 : 0; i < n; i++) {
+    if (id[i] < '0' || id[i] > '9') return false;
+  }
+  return n > (id[0] == '-' ? 1u : 0u);
+}
+
+static int findRecipient(const char* id) {
+  for (int i = 0; i < recipientCount; i++) {
+    if (strcmp(recipients[i], id) == 0) return i;
+  }
+  return -1;
 }
 
-String getSettingsKeyboard() {
-  String json = "[";
-  json += "[\"⏱ Длительность\", \"🎞 FPS\"],";
-  json += "[\"🔦 Фонарик\", \"🔙 Назад\"]";
-  json += "]";
-  return json;
+// Основной чат или один из получателей видео
+static bool isAuthorizedChat(const String &id) {
+  return id.length() > 0 && (id == chatId || findRecipient(id.c_str()) >= 0);
 }
 
-String getDurationKeyboard() {
-   String json = "[";
-   json += "[\"⏱ 30с\", \"⏱ 5 мин\"],";
-   json += "[\"⏱ 15 мин\", \"⏱ 30 мин\"],";
-   json += "[\"🔙 Назад\"]";
-   json += "]";
-   return json;
+// Команды, которые меняют список получателей или выдают клипы из каталога
+static bool isRecipientCommand(const String &text) {
+  return text == "/addchat" || text.startsWith("/addchat ") || text.startsWith("/delchat ") ||
+         text == "/chats" || text == "/clips" || text.startsWith("/send ");
 }
 
-String getFPSKeyboard() {
-   String json = "[";
-   json += "[\"🎞 10\", \"🎞 15\", \"🎞 20\"],";
-   json += "[\"🎞 25\", \"🎞 30\", \"🔙 Назад\"]";
-   json += "]";
-   return json;
+static void saveRecipients(Preferences &prefs) {
+  char list[MAX_RECIPIENTS * CHAT_ID_MAX];
+  size_t len = 0;
+  list[0] = 0;
+  for (int i = 0; i < recipientCount; i++) {
+    len = appendLen(len, sizeof(list), snprintf(list + len, sizeof(list) - len, "%s%s", i ? "," : "", recipients[i]));
+  }
+  prefs.putString("chats", list);
 }
 
-String getFlashKeyboard() {
-    String json = "[";
-    json += "[\"🔦 Выкл\", \"🔦 Слабый\"],";
-    json += "[\"🔦 Средний\", \"🔦 Макс\"],";
-    json += "[\"🔙 Назад\"]";
-    json += "]";
-    return json;
+void loadRecipients(Preferences &prefs) {
+  String saved = prefs.getString("chats", "");
+  recipientCount = 0;
+  const char* p = saved.c_str();
+  while (*p && recipientCount < MAX_RECIPIENTS) {
+    const char* end = strchr(p, ',');
+    size_t n = end ? (size_t)(end - p) : strlen(p);
+    if (n > 0 && n < CHAT_ID_MAX) {
+      memcpy(recipients[recipientCount], p, n);
+      recipients[recipientCount][n] = 0;
+      if (validChatId(recipients[recipientCount])) recipientCount++;
+    }
+    p = end ? end + 1 : p + n;
+  }
 }
 
-String getKeyboard() {
-    return getMainKeyboard();
+static bool resendClip(int index, const char* chat);
+
+// Клавиатуры - константы во flash, собирать их в куче не нужно
+static const char MAIN_KEYBOARD[] =
+  "[[\"▶️ Начать запись\", \"⏹ Остановить\"],"
+  "[\"⚙ Настройки\", \"ℹ️ Статус\"]]";
+
+static const char SETTINGS_KEYBOARD[] =
+  "[[\"⏱ Длительность\", \"🎞 FPS\"],"
+  "[\"🔦 Фонарик\", \"🔙 Назад\"]]";
+
+static const char DURATION_KEYBOARD[] =
+  "[[\"⏱ 30с\", \"⏱ 5 мин\"],"
+  "[\"⏱ 15 мин\", \"⏱ 30 мин\"],"
+  "[\"🔙 Назад\"]]";
+
+static const char FPS_KEYBOARD[] =
+  "[[\"🎞 10\", \"🎞 15\", \"🎞 20\"],"
+  "[\"🎞 25\", \"🎞 30\", \"🔙 Назад\"]]";
+
+static const char FLASH_KEYBOARD[] =
+  "[[\"🔦 Выкл\", \"🔦 Слабый\"],"
+  "[\"🔦 Средний\", \"🔦 Макс\"],"
+  "[\"🔙 Назад\"]]";
+
+const char* getKeyboard() {
+    return MAIN_KEYBOARD;
 }
 
 bool checkStopCommand() {
@@ -85,14 +166,14 @@ bool checkStopCommand() {
     String text = bot.messages[i].text;
     text.trim();
     if (text == "/stop" || text == "⏹ Остановить") {
-      bot.sendMessageWithReplyKeyboard(bot.messages[i].chat_id, "⏹ Остановка записи...", "", getMainKeyboard(), true);
+      bot.sendMessageWithReplyKeyboard(bot.messages[i].chat_id, "⏹ Остановка записи...", "", MAIN_KEYBOARD, true);
       return true;
     }
   }
   return false;
 }
 
-void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordDuration, int &fps, int &jpegQuality, framesize_t &frameSize, int &flashBrightness, Preferences &prefs) {
+void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordDuration, int &fps, int &jpegQuality, framesize_t &frameSize, int &flashBrightness, RoiWindow &roi, Preferences &prefs) {
   Serial.printf("Handling %d messages. Free Heap: %d\n", numNewMessages, ESP.getFreeHeap());
   
   for (int i = 0; i < numNewMessages; i++) {
@@ -100,53 +181,83 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
     String chat_id = bot.messages[i].chat_id;
     
     text.trim();
-    Serial.println("Telegram Msg: [" + text + "] from: " + chat_id);
+    Serial.printf("Telegram Msg: [%s] from: %s\n", text.c_str(), chat_id.c_str());
 
     // --- Навигация и основные команды ---
 
-    if (text == "/start" || text == "/Start" || text == "❓ Помощь" || text == "🔙 Назад") {
+    bool startCommand = text == "/start" || text == "/Start" || text == "❓ Помощь" || text == "🔙 Назад";
+
+    // /start делает чат основным. Если основной чат уже задан, перехватить его
+    // может только получатель видео - иначе любой чат получил бы доступ к каталогу
+    if (startCommand && chatId != "" && !isAuthorizedChat(chat_id)) {
+      Serial.printf("/start из чужого чата %s отклонен\n", chat_id.c_str());
+      bot.sendMessage(chat_id, "⛔ Бот уже привязан к другому чату", "");
+    }
+    else if (startCommand) {
+      // Получатель становится основным чатом, прежний основной - получателем
+      int idx = findRecipient(chat_id.c_str());
+      if (idx >= 0) {
+        strlcpy(recipients[idx], chatId.c_str(), CHAT_ID_MAX);
+        saveRecipients(prefs);
+      }
       chatId = chat_id;
       prefs.putString("chatId", chatId);
       isRecordingActive = false; 
+      prefs.putBool("recording", isRecordingActive);
       
-      String welcome = "🤖 ESP32-CAM Видео Бот\n\n";
-      welcome += "Текущие настройки:\n";
-      welcome += "⏱ Длительность: " + String(recordDuration) + "с\n";
-      welcome += "🎞 FPS: " + String(fps) + "\n";
-      welcome += "🔦 Яркость: " + String(map(flashBrightness, 0, 255, 0, 100)) + "%\n";
+      char welcome[LOG_MSG_MAX];
+      snprintf(welcome, sizeof(welcome),
+        "🤖 ESP32-CAM Видео Бот\n\n"
+        "Текущие настройки:\n"
+        "⏱ Длительность: %dс\n"
+        "🎞 FPS: %d\n"
+        "🔦 Яркость: %ld%%\n",
+        recordDuration, fps, map(flashBrightness, 0, 255, 0, 100));
       
-      bot.sendMessageWithReplyKeyboard(chatId, welcome, "", getMainKeyboard(), true);
+      bot.sendMessageWithReplyKeyboard(chatId, welcome, "", MAIN_KEYBOARD, true);
     }
     else if (text == "/stop" || text == "⏹ Остановить") {
       isRecordingActive = false;
-      bot.sendMessageWithReplyKeyboard(chatId, "⏹ Запись остановлена.", "", getMainKeyboard(), true);
+      prefs.putBool("recording", isRecordingActive);
+      bot.sendMessageWithReplyKeyboard(chatId, "⏹ Запись остановлена.", "", MAIN_KEYBOARD, true);
     }
     else if (text == "/record" || text == "▶️ Начать запись") {
       isRecordingActive = true;
-      bot.sendMessageWithReplyKeyboard(chatId, "▶️ Запись началась...", "", getMainKeyboard(), true);
+      prefs.putBool("recording", isRecordingActive); // Запись возобновится после перезагрузки
+      bot.sendMessageWithReplyKeyboard(chatId, "▶️ Запись началась...", "", MAIN_KEYBOARD, true);
     }
     else if (text == "/status" || text == "ℹ️ Статус") {
-      String stat = "Статус: " + String(isRecordingActive ? "АКТИВЕН" : "ОЖИДАНИЕ") + "\n";
-      stat += "FPS: " + String(fps) + "\n";
-      stat += "Время: " + String(recordDuration) + "с\n";
-      stat += "Свет: " + String(flashBrightness) + "/255\n";
-      stat += "SD Free: " + String((SD_MMC.totalBytes() - SD_MMC.usedBytes())/1024/1024) + "MB";
-      bot.sendMessageWithReplyKeyboard(chatId, stat, "", getMainKeyboard(), true);
+      char stat[STATUS_MSG_MAX];
+      size_t len = 0;
+      len = appendLen(len, sizeof(stat), snprintf(stat, sizeof(stat),
+        "Статус: %s\n"
+        "FPS: %d\n"
+        "Время: %dс\n"
+        "Свет: %d/255\n"
+        "SD Free: %lluMB\n",
+        isRecordingActive ? "АКТИВЕН" : "ОЖИДАНИЕ", fps, recordDuration, flashBrightness,
+        (unsigned long long)((SD_MMC.totalBytes() - SD_MMC.usedBytes()) / 1024 / 1024)));
+      len = appendLen(len, sizeof(stat), formatRoiStatus(roi, stat + len, sizeof(stat) - len));
+      len = appendLen(len, sizeof(stat), snprintf(stat + len, sizeof(stat) - len, "\n"));
+      len = appendLen(len, sizeof(stat), formatCaptureStatus(stat + len, sizeof(stat) - len));
+      len = appendLen(len, sizeof(stat), snprintf(stat + len, sizeof(stat) - len, "\n"));
+      formatMemoryStats(stat + len, sizeof(stat) - len);
+      bot.sendMessageWithReplyKeyboard(chatId, stat, "", MAIN_KEYBOARD, true);
     }
     
     // --- Меню настроек ---
     
     else if (text == "⚙ Настройки") {
-        bot.sendMessageWithReplyKeyboard(chatId, "Выберите категорию настроек:", "", getSettingsKeyboard(), true);
+        bot.sendMessageWithReplyKeyboard(chatId, "Выберите категорию настроек:", "", SETTINGS_KEYBOARD, true);
     }
     else if (text == "⏱ Длительность") {
-        bot.sendMessageWithReplyKeyboard(chatId, "Выберите длительность видео:", "", getDurationKeyboard(), true);
+        bot.sendMessageWithReplyKeyboard(chatId, "Выберите длительность видео:", "", DURATION_KEYBOARD, true);
     }
     else if (text == "🎞 FPS") {
-        bot.sendMessageWithReplyKeyboard(chatId, "Выберите FPS (кадров в секунду):", "", getFPSKeyboard(), true);
+        bot.sendMessageWithReplyKeyboard(chatId, "Выберите FPS (кадров в секунду):", "", FPS_KEYBOARD, true);
     }
     else if (text == "🔦 Фонарик") {
-        bot.sendMessageWithReplyKeyboard(chatId, "Выберите яркость фонарика:", "", getFlashKeyboard(), true);
+        bot.sendMessageWithReplyKeyboard(chatId, "Выберите яркость фонарика:", "", FLASH_KEYBOARD, true);
     }
 
     // --- Обработчики конкретных настроек ---
@@ -177,7 +288,7 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
         if (val >= 30 && val <= 1800) {
             recordDuration = val;
             prefs.putInt("duration", recordDuration);
-            bot.sendMessage(chatId, "✅ Длительность установлена: " + String(val) + " сек");
+            replyf("✅ Длительность установлена: %d сек", val);
         } else {
             bot.sendMessage(chatId, "⚠️ Ошибка: диапазон 30 - 1800 сек.");
         }
@@ -189,7 +300,7 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
         if (val >= 10 && val <= 30) {
             fps = val;
             prefs.putInt("fps", fps);
-            bot.sendMessage(chatId, "✅ FPS установлен: " + String(val));
+            replyf("✅ FPS установлен: %d", val);
         }
     }
     else if (text.startsWith("/fps ")) {
@@ -197,7 +308,7 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
         if (val >= 10 && val <= 30) {
             fps = val;
             prefs.putInt("fps", fps);
-            bot.sendMessage(chatId, "✅ FPS установлен: " + String(val));
+            replyf("✅ FPS установлен: %d", val);
         } else {
              bot.sendMessage(chatId, "⚠️ Ошибка: диапазон 10 - 30.");
         }
@@ -234,12 +345,115 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
             flashBrightness = val;
             ledcWrite(FLASH_GPIO_NUM, flashBrightness);
             prefs.putInt("flash", flashBrightness);
-            bot.sendMessage(chatId, "✅ Яркость: " + String(val));
+            replyf("✅ Яркость: %d", val);
         } else {
             bot.sendMessage(chatId, "⚠️ 0 - 255");
         }
     }
     
+    // --- Получатели и каталог клипов ---
+
+    // Только для основного чата и получателей: иначе любой чат мог бы
+    // добавить себя в рассылку или забрать клипы через /send
+    else if (isRecipientCommand(text) && !isAuthorizedChat(chat_id)) {
+        Serial.printf("Команда %s из чужого чата %s отклонена\n", text.c_str(), chat_id.c_str());
+        bot.sendMessage(chat_id, "⛔ Команда доступна только основному чату и получателям видео", "");
+    }
+
+    // "/addchat" - добавить текущий чат, "/addchat <id>" - добавить чат или канал по ID
+    else if (text == "/addchat" || text.startsWith("/addchat ")) {
+        String id = text.substring(8);
+        id.trim();
+        if (id == "") id = chat_id;
+        if (!validChatId(id.c_str())) {
+            bot.sendMessage(chatId, "⚠️ Формат: /addchat <ID чата или @канал>");
+        } else if (id == chatId || findRecipient(id.c_str()) >= 0) {
+            replyf("Чат %s уже получает видео", id.c_str());
+        } else if (recipientCount >= MAX_RECIPIENTS) {
+            replyf("⚠️ Не больше %d дополнительных получателей", MAX_RECIPIENTS);
+        } else {
+            strlcpy(recipients[recipientCount++], id.c_str(), CHAT_ID_MAX);
+            saveRecipients(prefs);
+            replyf("✅ Чат %s добавлен. Видео загружается один раз и пересылается по file_id", id.c_str());
+        }
+    }
+    else if (text.startsWith("/delchat ")) {
+        String id = text.substring(9);
+        id.trim();
+        int idx = findRecipient(id.c_str());
+        if (idx < 0) {
+            replyf("⚠️ Чата %s нет в списке получателей", id.c_str());
+        } else {
+            recipients[idx][0] = 0;
+            for (int r = idx; r + 1 < recipientCount; r++) {
+                strlcpy(recipients[r], recipients[r + 1], CHAT_ID_MAX);
+            }
+            recipientCount--;
+            saveRecipients(prefs);
+            replyf("✅ Чат %s удален", id.c_str());
+        }
+    }
+    else if (text == "/chats") {
+        char list[LOG_MSG_MAX];
+        size_t len = 0;
+        len = appendLen(len, sizeof(list), snprintf(list, sizeof(list), "Получатели видео:\n%s (основной, логи)\n",
+                                                    chatId.c_str()));
+        for (int r = 0; r < recipientCount; r++) {
+            len = appendLen(len, sizeof(list), snprintf(list + len, sizeof(list) - len, "%s\n", recipients[r]));
+        }
+        snprintf(list + len, sizeof(list) - len, "Добавить: /addchat <ID>, удалить: /delchat <ID>");
+        bot.sendMessage(chatId, list, "");
+    }
+    else if (text == "/clips") {
+        char list[STATUS_MSG_MAX];
+        formatCatalog(list, sizeof(list), CATALOG_LIST_MAX);
+        bot.sendMessage(chat_id, list, "");
+    }
+    else if (text.startsWith("/send ")) {
+        int num = text.substring(6).toInt();
+        resendClip(num - 1, chat_id.c_str());
+    }
+
+    // Область интереса: "/roi x y w h" (проценты кадра), "/roi off", "/roi"
+    else if (text == "/roi" || text.startsWith("/roi ")) {
+        RoiWindow next = roi;
+        String args = text.substring(4);
+        args.trim();
+        int x, y, w, h;
+        char msg[128];
+        if (args == "") {
+            formatRoiStatus(roi, msg, sizeof(msg));
+            replyf("%s\nФормат: /roi x y ширина высота (в %% кадра) или /roi off", msg);
+            continue;
+        } else if (args == "off") {
+            next.enabled = false;
+        } else if (sscanf(args.c_str(), "%d %d %d %d", &x, &y, &w, &h) == 4) {
+            next.enabled = true;
+            next.x = x;
+            next.y = y;
+            next.w = w;
+            next.h = h;
+            if (!roiValid(next)) {
+                replyf("⚠️ Окно должно быть внутри кадра, ширина и высота от %d%%", ROI_MIN_PERCENT);
+                continue;
+            }
+        } else {
+            bot.sendMessage(chatId, "⚠️ Формат: /roi x y ширина высота (в % кадра) или /roi off");
+            continue;
+        }
+
+        if (roiApply(next, frameSize, fps) || !next.enabled) {
+            roi = next;
+            roiSave(prefs, roi);
+            formatRoiStatus(roi, msg, sizeof(msg));
+            replyf("✅ %s", msg);
+        } else {
+            // Окно не применилось (не OV2640 или ошибка сенсора): возвращаем прежнее
+            roiApply(roi, frameSize, fps);
+            bot.sendMessage(chatId, "⚠️ Не удалось настроить окно сенсора (ROI работает только с OV2640)");
+        }
+    }
+
     // --- Числовые команды (Быстрая настройка) ---
     else if (text.toInt() != 0 || text == "0") {
         int val = text.toInt();
@@ -248,13 +462,13 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
         if (val >= 10 && val <= 30) {
              fps = val;
              prefs.putInt("fps", fps);
-             bot.sendMessage(chatId, "✅ FPS установлен: " + String(val));
+             replyf("✅ FPS установлен: %d", val);
         }
         // Если число побольше (30-1800), считаем это длительностью
         else if (val >= 30 && val <= 1800) {
              recordDuration = val;
              prefs.putInt("duration", recordDuration);
-             bot.sendMessage(chatId, "✅ Длительность установлена: " + String(val) + " сек");
+             replyf("✅ Длительность установлена: %d сек", val);
         }
         else {
              bot.sendMessage(chatId, "⚠️ Непонятное число.\nFPS: 10-30\nВремя: 30-1800", "");
@@ -268,90 +482,262 @@ void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordD
   }
 }
 
-bool sendVideoToTelegram(String filename) {
+// Строковое поле key верхнего уровня JSON объекта obj (obj указывает на '{').
+// Вложенные объекты пропускаются: у video есть thumbnail со своим file_id
+static bool jsonObjectString(const char* obj, const char* key, char* out, size_t cap) {
+  size_t keyLen = strlen(key);
+  int depth = 0;
+  for (const char* p = obj; *p; p++) {
+    if (*p == '{' || *p == '[') {
+      depth++;
+    } else if (*p == '}' || *p == ']') {
+      if (--depth == 0) return false;
+    } else if (*p == '"') {
+      const char* str = ++p;
+      while (*p && *p != '"') {
+        if (*p == '\\' && p[1]) p++;
+        p++;
+      }
+      if (!*p) return false;
+      // Ключ верхнего уровня, за которым идет строковое значение
+      if (depth == 1 && (size_t)(p - str) == keyLen && strncmp(str, key, keyLen) == 0 &&
+          p[1] == ':' && p[2] == '"') {
+        const char* val = p + 3;
+        const char* end = strchr(val, '"');
+        if (!end || (size_t)(end - val) >= cap) return false;
+        memcpy(out, val, end - val);
+        out[end - val] = 0;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// file_id из ответа sendVideo. Telegram может вернуть файл как video,
+// animation или document - пересылать его нужно тем же методом
+static bool extractFileId(const char* response, ClipRecord &rec) {
+  static const char* const kinds[] = { "video", "animation", "document" };
+  const char* result = strstr(response, "\"result\":");
+  if (!result) return false;
+  for (const char* kind : kinds) {
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), "\"%s\":{", kind);
+    const char* obj = strstr(result, pattern);
+    if (obj && jsonObjectString(obj + strlen(pattern) - 1, "file_id", rec.fileId, sizeof(rec.fileId))) {
+      strlcpy(rec.kind, kind, sizeof(rec.kind));
+      return true;
+    }
+  }
+  return false;
+}
+
+// Загрузка файла в один чат. При успехе в rec записываются размер и file_id
+static bool uploadVideo(const char* filename, const char* chat, ClipRecord &rec) {
   File file = SD_MMC.open(filename, FILE_READ);
   if (!file) {
-    logToBot("Ошибка: Не могу открыть файл для отправки: " + filename);
+    logToBotf("Ошибка: Не могу открыть файл для отправки: %s", filename);
     return false;
   }
   
   size_t fileSize = file.size();
+  strlcpy(rec.path, filename, sizeof(rec.path));
+  rec.size = fileSize;
+  rec.kind[0] = 0;
+  rec.fileId[0] = 0;
   
   if (fileSize == 0) {
-    logToBot("Ошибка: Файл пуст: " + filename);
+    logToBotf("Ошибка: Файл пуст: %s", filename);
     file.close();
     return false;
   }
   
-  logToBot("Отправка видео (" + String(fileSize/1024.0/1024.0, 2) + " MB)...");
+  logToBotf("Отправка видео (%.2f MB)...", fileSize / 1024.0 / 1024.0);
 
-  // Подготовка HTTP POST запроса
-  String start_request = "";
-  String end_request = "";
-  String boundary = "------------------------ESP32CAMBotBoundary";
-  
-  start_request += "--" + boundary + "\r\n";
-  start_request += "Content-Disposition: form-data; name=\"chat_id\"\r\n\r\n";
-  start_request += chatId + "\r\n";
-  start_request += "--" + boundary + "\r\n";
-  start_request += "Content-Disposition: form-data; name=\"video\"; filename=\"video.avi\"\r\n";
-  start_request += "Content-Type: video/x-msvideo\r\n\r\n";
-  
-  end_request += "\r\n--" + boundary + "--\r\n";
+  // Подготовка HTTP POST запроса (буферы фиксированного размера)
+  static const char boundary[] = "------------------------ESP32CAMBotBoundary";
+  char start_request[320];
+  char end_request[64];
+
+  snprintf(start_request, sizeof(start_request),
+    "--%s\r\n"
+    "Content-Disposition: form-data; name=\"chat_id\"\r\n\r\n"
+    "%s\r\n"
+    "--%s\r\n"
+    "Content-Disposition: form-data; name=\"video\"; filename=\"video.avi\"\r\n"
+    "Content-Type: video/x-msvideo\r\n\r\n",
+    boundary, chat, boundary);
+  snprintf(end_request, sizeof(end_request), "\r\n--%s--\r\n", boundary);
   
-  size_t totalLen = start_request.length() + fileSize + end_request.length();
+  size_t totalLen = strlen(start_request) + fileSize + strlen(end_request);
+  unsigned long requestStart = millis(); // Для оценки канала: вместе с TLS и ожиданием ответа
   
   // Подключение к API
-  if (client.connect("api.telegram.org", 443)) {
-    client.println("POST /bot" + String(BOT_TOKEN) + "/sendVideo HTTP/1.1");
-    client.println("Host: api.telegram.org");
-    client.println("Content-Type: multipart/form-data; boundary=" + boundary);
-    client.println("Content-Length: " + String(totalLen));
-    client.println();
+  if (client.connect(TELEGRAM_API_HOST, TELEGRAM_API_PORT)) {
+    client.printf("POST /bot%s/sendVideo HTTP/1.1\r\n", BOT_TOKEN);
+    client.printf("Host: %s\r\n", TELEGRAM_API_HOST);
+    client.printf("Content-Type: multipart/form-data; boundary=%s\r\n", boundary);
+    client.printf("Content-Length: %u\r\n", (unsigned)totalLen);
+    client.print("Connection: close\r\n");
+    client.print("\r\n");
     
     client.print(start_request);
     
-    // Потоковая передача файла
-    uint8_t *buffer = (uint8_t*)malloc(4096);
-    if (!buffer) {
+    // Потоковая передача файла: чтение SD и отправка идут параллельно
+    // Все буферы - из арены во внутренней DMA памяти (без malloc на каждую отправку)
+    netArena.reset();
+    char *response = netArena.allocArray<char>(HTTP_BODY_MAX);
+    UploadResult upload;
+    if (!response || !uploadStreamFile(file, client, upload)) {
         client.stop(); // Остановить клиент перед логгированием (который может попытаться отправить сообщение)
-        logToBot("Ошибка: Не хватает памяти для буфера отправки");
         file.close();
+        if (!response) {
+          logToBot("Ошибка: Не хватает памяти для буфера отправки");
+        } else {
+          // Обрыв - тоже замер канала: сколько успели передать за потраченное время
+          linkEstimateAdd(strlen(start_request) + upload.bytes, millis() - requestStart, WiFi.RSSI());
+          logToBotf("Ошибка: Отправка прервана после %.2f MB", upload.bytes / 1024.0 / 1024.0);
+        }
         return false;
     }
-    
-    size_t sent = 0;
-    while (file.available()) {
-      size_t read = file.read(buffer, 4096);
-      client.write(buffer, read);
-      sent += read;
-      
-      // Опционально: Сброс watchdog или вывод прогресса
-      if (sent % (1024*1024) == 0) Serial.print("."); 
-    }
-    free(buffer);
+    file.close();
     
     client.print(end_request);
     
-    // Ожидание ответа
-    unsigned long wait = millis();
-    bool success = false;
-    while (client.connected() && millis() - wait < 20000) {
-      if (client.available()) {
-        String line = client.readStringUntil('\n');
-        if (line.indexOf("\"ok\":true") != -1) {
-          success = true;
-        }
-        // Serial.println(line); // Debug response
+    // Ожидание и разбор ответа
+    int status = readHttpResponse(client, response, HTTP_BODY_MAX, HTTP_RESPONSE_TIMEOUT_MS);
+    client.stop();
+
+    bool success = (status == 200) && strstr(response, "\"ok\":true") != nullptr;
+    // Файл передан целиком, даже если сервер ответил ошибкой или не ответил вовремя
+    linkEstimateAdd(totalLen, millis() - requestStart, WiFi.RSSI());
+    if (success) {
+      if (!extractFileId(response, rec)) {
+        Serial.println("Предупреждение: file_id не найден в ответе, пересылка будет с загрузкой");
       }
+      logToBotf("Отправлено %.2f MB за %.1f с: %.0f КБ/с (чанк %u КБ)",
+                upload.bytes / 1024.0 / 1024.0, upload.elapsedMs / 1000.0, upload.kbps(),
+                (unsigned)(upload.chunkSize / 1024));
+    } else {
+      // Ответ Telegram об ошибке, например {"ok":false,"error_code":413,...}
+      logToBotf("Ошибка отправки: HTTP %d %.200s", status, response);
     }
-    client.stop();
-    file.close();
     
     return success;
   } else {
-    logToBot("Ошибка: Не удалось подключиться к api.telegram.org");
+    // Штрафной замер: время ушло, данные не переданы
+    linkEstimateAdd(0, millis() - requestStart, WiFi.RSSI());
+    logToBot("Ошибка: Не удалось подключиться к " TELEGRAM_API_HOST);
     file.close();
     return false;
   }
 }
+
+// Отправка уже загруженного клипа по file_id: короткий JSON запрос без байтов видео
+static bool sendCachedVideo(const char* chat, const ClipRecord &rec) {
+  if (!rec.fileId[0]) return false;
+
+  // video -> sendVideo, animation -> sendAnimation, document -> sendDocument
+  char method[24];
+  snprintf(method, sizeof(method), "send%c%s", toupper(rec.kind[0]), rec.kind + 1);
+  char body[CHAT_ID_MAX + FILE_ID_MAX + 64];
+  int bodyLen = snprintf(body, sizeof(body), "{\"chat_id\":\"%s\",\"%s\":\"%s\"}", chat, rec.kind, rec.fileId);
+
+  if (!client.connect(TELEGRAM_API_HOST, TELEGRAM_API_PORT)) {
+    Serial.println("Ошибка: Не удалось подключиться к " TELEGRAM_API_HOST);
+    return false;
+  }
+  client.printf("POST /bot%s/%s HTTP/1.1\r\n", BOT_TOKEN, method);
+  client.printf("Host: %s\r\n", TELEGRAM_API_HOST);
+  client.print("Content-Type: application/json\r\n");
+  client.printf("Content-Length: %d\r\n", bodyLen);
+  client.print("Connection: close\r\n");
+  client.print("\r\n");
+  client.print(body);
+
+  netArena.reset();
+  char *response = netArena.allocArray<char>(HTTP_BODY_MAX);
+  if (!response) {
+    client.stop();
+    return false;
+  }
+  int status = readHttpResponse(client, response, HTTP_BODY_MAX, HTTP_RESPONSE_TIMEOUT_MS);
+  client.stop();
+
+  bool success = (status == 200) && strstr(response, "\"ok\":true") != nullptr;
+  if (!success) {
+    Serial.printf("Ошибка пересылки в %s: HTTP %d %.200s\n", chat, status, response);
+  }
+  return success;
+}
+
+// Доставка клипа в чат: по file_id, а если его нет - загрузкой файла с SD
+static bool deliverClip(const char* filename, const char* chat, ClipRecord &rec, bool &uploaded) {
+  uploaded = false;
+  if (rec.fileId[0]) return sendCachedVideo(chat, rec);
+  if (!SD_MMC.exists(filename)) return false;
+  uploaded = true;
+  return uploadVideo(filename, chat, rec);
+}
+
+// Файл на SD - тот же клип, что в каталоге (а не новый файл с тем же именем)
+static bool clipFileMatches(const ClipRecord &rec) {
+  File f = SD_MMC.open(rec.path, FILE_READ);
+  if (!f) return false;
+  bool same = f.size() == rec.size;
+  f.close();
+  return same;
+}
+
+// Повторная отправка клипа из каталога (/send <номер>)
+static bool resendClip(int index, const char* chat) {
+  if (!isAuthorizedChat(chat)) return false;
+  ClipRecord rec;
+  if (!catalogGet(index, rec)) {
+    bot.sendMessage(chat, "⚠️ Нет такого клипа. Список: /clips", "");
+    return false;
+  }
+  if (!rec.fileId[0] && !clipFileMatches(rec)) {
+    bot.sendMessage(chat, "⚠️ Клип удален с карты и не был загружен в Telegram", "");
+    return false;
+  }
+  bool uploaded = false;
+  if (!deliverClip(rec.path, chat, rec, uploaded)) {
+    bot.sendMessage(chat, "⚠️ Не удалось отправить клип", "");
+    return false;
+  }
+  // Первый file_id для клипа, который раньше не удалось отправить, - в каталог
+  if (uploaded && rec.fileId[0]) {
+    catalogUpdate(index, rec);
+  }
+  return true;
+}
+
+// Рассылка клипа: файл загружается один раз (в основной чат), остальные
+// получатели получают его по file_id из ответа Telegram - без повторной загрузки
+bool sendVideoToTelegram(const char* filename) {
+  ClipRecord rec;
+  bool sent = uploadVideo(filename, chatId.c_str(), rec);
+  // В каталог попадает и неудачная отправка: ее можно повторить через /send.
+  // Пустой путь - файл даже не открылся, повторять нечего
+  int index = rec.path[0] ? catalogAdd(rec) : -1;
+  if (!sent) return false;
+
+  if (recipientCount == 0) return true;
+
+  bool hadFileId = rec.fileId[0] != 0;
+  unsigned long fanoutStart = millis();
+  int delivered = 1;
+  int uploads = 1;
+  for (int r = 0; r < recipientCount; r++) {
+    bool uploaded = false;
+    if (deliverClip(filename, recipients[r], rec, uploaded)) delivered++;
+    if (uploaded) uploads++;
+  }
+  // Если в первом ответе не было file_id, он мог появиться при загрузке другому получателю
+  if (!hadFileId && index >= 0 && rec.fileId[0]) catalogUpdate(index, rec);
+
+  logToBotf("Доставлено в %d из %d чатов за %.1f с, загрузок файла: %d",
+            delivered, recipientCount + 1, (millis() - fanoutStart) / 1000.0, uploads);
+  return true;
+}
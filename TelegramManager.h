@@ -7,16 +7,19 @@
 #include <UniversalTelegramBot.h>
 #include <Preferences.h>
 #include "esp_camera.h"
+#include "SensorWindow.h"
 
 // Делаем доступными для других модулей
 extern WiFiClientSecure client;
 extern UniversalTelegramBot bot;
 extern String chatId;
 
-void logToBot(String msg);
-bool sendVideoToTelegram(String filename);
-void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordDuration, int &fps, int &jpegQuality, framesize_t &frameSize, int &flashBrightness, Preferences &prefs);
-String getKeyboard();
+void logToBot(const char* msg);
+void logToBotf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+bool sendVideoToTelegram(const char* filename);
+void loadRecipients(Preferences &prefs);
+void handleNewMessages(int numNewMessages, bool &isRecordingActive, int &recordDuration, int &fps, int &jpegQuality, framesize_t &frameSize, int &flashBrightness, RoiWindow &roi, Preferences &prefs);
+const char* getKeyboard();
 bool checkStopCommand();
 
 #endif
@@ -0,0 +1,228 @@
+#include "Uploader.h"
+#include "Config.h"
+#include "MemoryPool.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+// Конвейер отправки: задача чтения заполняет кольцо буферов с SD карты,
+// а вызывающая задача параллельно отправляет заполненные буферы в TLS сокет.
+// Буфер с len == 0 означает конец файла (или ошибку чтения).
+struct UploadChunk {
+  uint8_t* buf;
+  size_t len;
+};
+
+static QueueHandle_t freeQueue = nullptr;  // Пустые буферы -> задача чтения
+static QueueHandle_t fullQueue = nullptr;  // Заполненные буферы -> отправка
+static SemaphoreHandle_t readerDone = nullptr;
+static File* readerFile = nullptr;
+static volatile size_t chunkSize = UPLOAD_CHUNK_MIN;
+static volatile bool abortUpload = false;
+static UploadResult lastResult;
+
+static void readerTask(void* arg) {
+  UploadChunk chunk;
+  while (!abortUpload) {
+    // Ожидание с тайм-аутом, чтобы заметить abortUpload
+    if (xQueueReceive(freeQueue, &chunk, pdMS_TO_TICKS(100)) != pdTRUE) continue;
+
+    chunk.len = readerFile->read(chunk.buf, chunkSize);
+    // В fullQueue помещаются все буферы кольца, поэтому отправка не блокируется
+    xQueueSend(fullQueue, &chunk, portMAX_DELAY);
+    if (chunk.len == 0) break;
+  }
+  xSemaphoreGive(readerDone);
+  vTaskDelete(NULL);
+}
+
+// Новый размер чанка: столько, сколько канал передает за UPLOAD_CHUNK_TARGET_MS.
+// Крупные чанки уменьшают накладные расходы TLS записей на быстром канале,
+// мелкие - не держат буферы подолгу на медленном.
+static size_t adaptChunkSize(size_t current, size_t written, unsigned long ms) {
+  if (ms == 0) ms = 1;
+  size_t ideal = (uint64_t)written * UPLOAD_CHUNK_TARGET_MS / ms;
+  size_t next = (current + ideal) / 2; // Сглаживание
+  next = constrain(next, (size_t)UPLOAD_CHUNK_MIN, (size_t)UPLOAD_BUFFER_SIZE);
+  return next & ~(size_t)511; // Кратно сектору SD
+}
+
+// Передача файла целиком в уже открытое соединение
+bool uploadStreamFile(File &file, Client &client, UploadResult &result) {
+  result = UploadResult();
+
+  if (!freeQueue) {
+    freeQueue = xQueueCreate(UPLOAD_RING_BUFFERS, sizeof(UploadChunk));
+    fullQueue = xQueueCreate(UPLOAD_RING_BUFFERS, sizeof(UploadChunk));
+    readerDone = xSemaphoreCreateBinary();
+  }
+  if (!freeQueue || !fullQueue || !readerDone) return false;
+  xQueueReset(freeQueue);
+  xQueueReset(fullQueue);
+  xSemaphoreTake(readerDone, 0);
+
+  // Кольцо буферов - из внутренней DMA памяти (чтение SD без промежуточного копирования)
+  for (int i = 0; i < UPLOAD_RING_BUFFERS; i++) {
+    UploadChunk chunk = { netArena.allocArray<uint8_t>(UPLOAD_BUFFER_SIZE), 0 };
+    if (!chunk.buf) {
+      if (i == 0) return false;
+      break; // Работаем с тем, что есть
+    }
+    xQueueSend(freeQueue, &chunk, 0);
+  }
+
+  // Размер - до запуска задачи чтения: size() делает fflush+fstat
+  // на том же FILE*, который задача читает с ядра 0
+  size_t fileSize = file.size();
+  readerFile = &file;
+  abortUpload = false;
+  chunkSize = UPLOAD_CHUNK_START;
+
+  // Чтение SD на ядре 0, отправка остается в текущей задаче (ядро 1)
+  if (xTaskCreatePinnedToCore(readerTask, "sd_reader", 4096, nullptr, 2, nullptr, 0) != pdPASS) {
+    return false;
+  }
+
+  unsigned long start = millis();
+  unsigned long lastDot = start;
+
+  while (true) {
+    UploadChunk chunk;
+    if (xQueueReceive(fullQueue, &chunk, pdMS_TO_TICKS(UPLOAD_STALL_TIMEOUT_MS)) != pdTRUE) {
+      Serial.println("Отправка: чтение SD не отвечает");
+      break;
+    }
+    if (chunk.len == 0) break;
+
+    unsigned long w0 = millis();
+    size_t off = 0;
+    while (off < chunk.len) {
+      size_t n = client.write(chunk.buf + off, chunk.len - off);
+      if (n == 0) break;
+      off += n;
+    }
+    unsigned long dt = millis() - w0;
+    result.bytes += off;
+    xQueueSend(freeQueue, &chunk, 0);
+
+    if (off < chunk.len) {
+      Serial.println("Отправка: соединение разорвано");
+      break;
+    }
+    chunkSize = adaptChunkSize(chunkSize, off, dt);
+
+    if (millis() - lastDot > 1000) {
+      lastDot = millis();
+      Serial.print(".");
+    }
+  }
+
+  // Останавливаем задачу чтения и ждем ее завершения (она владеет File)
+  abortUpload = true;
+  xSemaphoreTake(readerDone, portMAX_DELAY);
+  readerFile = nullptr;
+
+  result.elapsedMs = millis() - start;
+  result.chunkSize = chunkSize;
+  result.complete = (result.bytes == fileSize);
+  lastResult = result;
+  Serial.println();
+  return result.complete;
+}
+
+// Итоги последней передачи файла (только тело, без соединения и ответа сервера)
+const UploadResult& lastUploadResult() {
+  return lastResult;
+}
+
+static LinkEstimate link;
+
+// Экспоненциальное сглаживание: первая отправка задает оценку, далее вес LINK_EWMA_ALPHA
+void linkEstimateAdd(size_t bytes, unsigned long elapsedMs, int rssi) {
+  if (elapsedMs == 0) elapsedMs = 1;
+  float rate = bytes * 1000.0f / elapsedMs;
+  if (link.samples == 0) {
+    link.bytesPerSec = rate;
+    link.rssi = rssi;
+  } else {
+    link.bytesPerSec += LINK_EWMA_ALPHA * (rate - link.bytesPerSec);
+    link.rssi += LINK_EWMA_ALPHA * (rssi - link.rssi);
+  }
+  link.samples++;
+}
+
+const LinkEstimate& linkEstimate() {
+  return link;
+}
+
+// Чтение одного байта ответа с ожиданием до deadline (-1 при тайм-ауте или закрытии)
+static int readByte(Client &client, unsigned long deadline) {
+  while (!client.available()) {
+    if (!client.connected() || (long)(millis() - deadline) > 0) return -1;
+    delay(1);
+  }
+  return client.read();
+}
+
+// Чтение строки без CR/LF. Возвращает длину или -1, если данных больше нет
+static int readLine(Client &client, char* line, size_t cap, unsigned long deadline) {
+  size_t n = 0;
+  int ch = -1;
+  while ((ch = readByte(client, deadline)) >= 0) {
+    if (ch == '\n') break;
+    if (ch != '\r' && n + 1 < cap) line[n++] = (char)ch;
+  }
+  line[n] = 0;
+  return (ch < 0 && n == 0) ? -1 : (int)n;
+}
+
+// Разбор HTTP ответа: строка статуса, заголовки, тело (Content-Length или chunked).
+// Тело сохраняется в body (обрезается до cap-1 байт). Возвращает код статуса или -1.
+int readHttpResponse(Client &client, char* body, size_t cap, unsigned long timeoutMs) {
+  unsigned long deadline = millis() + timeoutMs;
+  char line[128];
+  body[0] = 0;
+
+  if (readLine(client, line, sizeof(line), deadline) < 0) return -1;
+  int status = -1;
+  if (sscanf(line, "HTTP/%*s %d", &status) != 1) return -1;
+
+  long contentLength = -1;
+  bool chunked = false;
+  int n;
+  while ((n = readLine(client, line, sizeof(line), deadline)) > 0) {
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      contentLength = atol(line + 15);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line + 18, "chunked")) {
+      chunked = true;
+    }
+  }
+  if (n < 0) return status; // Соединение закрыто сразу после заголовков
+
+  size_t stored = 0;
+  auto keep = [&](int ch) {
+    if (stored + 1 < cap) body[stored++] = (char)ch;
+  };
+
+  if (chunked) {
+    while (readLine(client, line, sizeof(line), deadline) >= 0) {
+      long size = strtol(line, nullptr, 16);
+      if (size <= 0) break;
+      for (long i = 0; i < size; i++) {
+        int ch = readByte(client, deadline);
+        if (ch < 0) break;
+        keep(ch);
+      }
+      readLine(client, line, sizeof(line), deadline); // CRLF после чанка
+    }
+  } else {
+    for (long i = 0; contentLength < 0 || i < contentLength; i++) {
+      int ch = readByte(client, deadline);
+      if (ch < 0) break;
+      keep(ch);
+    }
+  }
+
+  body[stored] = 0;
+  return status;
+}
@@ -0,0 +1,31 @@
+#ifndef UPLOADER_H
+#define UPLOADER_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <FS.h>
+
+// Итоги передачи одного файла
+struct UploadResult {
+  size_t bytes = 0;            // Передано байт файла
+  unsigned long elapsedMs = 0; // Время передачи тела файла
+  size_t chunkSize = 0;        // Размер чанка к концу передачи (после адаптации)
+  bool complete = false;       // Файл передан целиком
+
+  float kbps() const { return elapsedMs > 0 ? bytes / 1024.0 * 1000.0 / elapsedMs : 0; }
+};
+
+// Скользящая оценка канала по отправкам (неудачные тоже учитываются, см. uploadVideo)
+struct LinkEstimate {
+  float bytesPerSec = 0;  // Достигнутая скорость с учетом соединения и ответа сервера
+  float rssi = 0;         // Уровень сигнала WiFi во время отправок, дБм
+  int samples = 0;
+};
+
+bool uploadStreamFile(File &file, Client &client, UploadResult &result);
+const UploadResult& lastUploadResult();
+void linkEstimateAdd(size_t bytes, unsigned long elapsedMs, int rssi);
+const LinkEstimate& linkEstimate();
+int readHttpResponse(Client &client, char* body, size_t cap, unsigned long timeoutMs);
+
+#endif
@@ -1,33 +1,143 @@
 #include "VideoRecorder.h"
 #include "Config.h"
 #include "AviUtils.h"
+#include "ProxyEncoder.h"
+#include "MemoryPool.h"
 #include "TelegramManager.h"
+#include "WifiManager.h"
 #include "SD_MMC.h"
 #include <WiFi.h>
-#include <vector>
 
-String recordVideo(int recordDuration, int fps, String ssid, String password) {
+unsigned long firstFrameMillis = 0;
+
+static Preferences *recPrefs = nullptr;
+static unsigned long nextClipNumber = 1;
+static bool proxyFailedLast = false; // Прокси прошлого клипа не открылся (нехватка памяти, SD)
+
+// Номер записи из имени файла "/video<номер>[_proxy].avi" (0 если не наш файл).
+// Номер - сквозной счетчик clip_n (см. recorderBegin), поэтому он же задает порядок записей
+static unsigned long recordingNumber(const char* name) {
+  const char* base = strrchr(name, '/');
+  base = base ? base + 1 : name;
+  if (strncmp(base, "video", 5) != 0) return 0;
+  if (!strstr(base, ".avi")) return 0;
+  return strtoul(base + 5, nullptr, 10);
+}
+
+// Самый большой номер записи на карте (0, если записей нет)
+static unsigned long newestRecordingNumber() {
+  File root = SD_MMC.open("/");
+  if (!root) return 0;
+  unsigned long newest = 0;
+  File entry = root.openNextFile();
+  while (entry) {
+    unsigned long num = recordingNumber(entry.name());
+    if (!entry.isDirectory() && num > newest) newest = num;
+    entry = root.openNextFile();
+  }
+  root.close();
+  return newest;
+}
+
+// Номера записей сквозные: счетчик хранится в prefs "clip_n" и не сбрасывается
+// при перезагрузке, поэтому имена не повторяются, а порядок номеров = порядок записи.
+// Вызывать после монтирования SD.
+void recorderBegin(Preferences &prefs) {
+  recPrefs = &prefs;
+  nextClipNumber = prefs.getUInt("clip_n", 0);
+  if (nextClipNumber == 0) {
+    // Первый запуск с этим счетчиком: продолжаем после записей, которые уже есть на карте
+    nextClipNumber = newestRecordingNumber() + 1;
+    prefs.putUInt("clip_n", nextClipNumber);
+  }
+}
+
+// Номер и имена файлов новой записи. Занятые имена пропускаются:
+// существующий файл никогда не перезаписывается
+static unsigned long claimClipNumber(char* fullPath, char* proxyPath, size_t cap) {
+  unsigned long num = nextClipNumber;
+  while (true) {
+    snprintf(fullPath, cap, "/video%lu.avi", num);
+    snprintf(proxyPath, cap, "/video%lu_proxy.avi", num);
+    if (!SD_MMC.exists(fullPath) && !SD_MMC.exists(proxyPath)) break;
+    num++;
+  }
+  nextClipNumber = num + 1;
+  if (recPrefs) recPrefs->putUInt("clip_n", nextClipNumber);
+  return num;
+}
+
+// Удаление самых старых записей, пока на карте не освободится MIN_FREE_SPACE_MB
+void pruneOldRecordings() {
+  while ((SD_MMC.totalBytes() - SD_MMC.usedBytes()) / 1024 / 1024 < MIN_FREE_SPACE_MB) {
+    File root = SD_MMC.open("/");
+    if (!root) return;
+
+    char oldest[32] = "";
+    unsigned long oldestNum = 0;
+    File entry = root.openNextFile();
+    while (entry) {
+      unsigned long num = recordingNumber(entry.name());
+      if (!entry.isDirectory() && num != 0 && (oldest[0] == 0 || num < oldestNum)) {
+        oldestNum = num;
+        strlcpy(oldest, entry.path(), sizeof(oldest));
+      }
+      entry = root.openNextFile();
+    }
+    root.close();
+
+    if (oldest[0] == 0) return; // Удалять больше нечего
+    Serial.printf("Мало места на SD, удаляю: %s\n", oldest);
+    if (!SD_MMC.remove(oldest)) {
+      // Иначе цикл бесконечно выбирал бы тот же файл
+      Serial.printf("Не удалось удалить %s, очистка прервана\n", oldest);
+      return;
+    }
+  }
+}
+
+// Будет ли у следующего клипа прокси: решает планировщик, какой файл считать
+// отправляемым. Без PSRAM прокси нет всегда, после неудачи - до первой удачной записи
+bool recorderProxyAvailable() {
+  return PROXY_ENABLED && recArena.inPsram() && !proxyFailedLast;
+}
+
+RecordedClip recordVideo(int recordDuration, int fps) {
+  RecordedClip clip;
   logToBot("Начало цикла записи...");
-  
-  String filename = "/video" + String(millis()) + ".avi";
-  
-  if (SD_MMC.exists(filename)) {
-    SD_MMC.remove(filename);
+
+  pruneOldRecordings();
+
+  char filename[32];
+  char proxyName[32];
+  claimClipNumber(filename, proxyName, sizeof(filename));
+
+  // Все буферы записи берутся из арены, которая сбрасывается перед каждым клипом
+  recArena.reset();
+  // Буферы прокси помещаются только в PSRAM, без нее пишется один полный поток
+  bool useProxy = PROXY_ENABLED && recArena.inPsram();
+  size_t maxFrames = recordDuration * fps;
+  size_t fitFrames = recArena.available() / sizeof(AviIndexEntry) / (useProxy ? 2 : 1);
+  if (maxFrames > fitFrames) {
+    // Плата без PSRAM: клип будет короче, чем задано
+    maxFrames = fitFrames;
+    Serial.printf("Мало памяти: клип ограничен %u кадрами\n", (unsigned)maxFrames);
   }
-  
-  File file = SD_MMC.open(filename, FILE_WRITE);
-  if (!file) {
+  size_t maxProxyFrames = maxFrames / PROXY_FRAME_DIVIDER + 1;
+  AviIndexEntry* fullIdx = recArena.allocArray<AviIndexEntry>(maxFrames);
+  AviIndexEntry* proxyIdx = useProxy ? recArena.allocArray<AviIndexEntry>(maxProxyFrames) : nullptr;
+
+  AviWriter full;
+  if (!avi_open(full, SD_MMC, filename, fps, fullIdx, maxFrames)) {
     logToBot("Ошибка: Не удалось открыть файл для записи");
-    return "";
+    return clip;
   }
-  
-  // Буфер для заголовка
-  uint8_t buf[avi_header_size];
 
-  // Запись пустого заголовка (будет обновлен позже)
-  prepare_avi_header_buffer(buf, 320, 240, fps); // Предполагаем QVGA 320x240
-  file.write(buf, avi_header_size);
-  
+  // Прокси-поток открывается после первого кадра, когда известно разрешение
+  AviWriter proxy;
+  bool proxyActive = false;
+  bool proxyFailed = !useProxy;
+
   // Примечание: Мы оставляем WiFi включенным для получения команд остановки
   // ВНИМАНИЕ: Это увеличивает потребление энергии. Требуется хорошее питание.
   // WiFi.disconnect(true);
@@ -36,16 +146,9 @@ String recordVideo(int recordDuration, int fps, String ssid, String password) {
   Serial.printf("Free Heap: %u\n", ESP.getFreeHeap());
   
   unsigned long startTime = millis();
-  int frames = 0;
-  int frames_size = 0;
   unsigned long lastFrameTime = 0;
   int interval = 1000 / fps;
   
-  // Индекс для перемотки
-  std::vector<AviIndexEntry> idx;
-  idx.reserve(recordDuration * fps); // Предварительное выделение памяти
-  uint32_t current_movi_offset = 4; // Начинаем после тега "movi"
-  
   // Состояние светодиода
   unsigned long lastBlink = 0;
   bool ledState = false;
@@ -56,6 +159,9 @@ String recordVideo(int recordDuration, int fps, String ssid, String password) {
   // Цикл записи
   while ((millis() - startTime) < (recordDuration * 1000)) {
     unsigned long now = millis();
+
+    // WiFi поднимается в фоне, пока идет запись
+    wifiService();
     
     // Проверка команды остановки каждые 5 секунд
     // Это вызовет паузу в видео на ~1-2 секунды
@@ -91,44 +197,60 @@ String recordVideo(int recordDuration, int fps, String ssid, String password) {
       continue;
     }
     
-    // Сохраняем длину кадра для индекса перед возвратом fb
+    // Сохраняем длину кадра для лога перед возвратом fb
     size_t frameLen = fb->len;
-    
-    // Индекс
-    idx.push_back({current_movi_offset, (uint32_t)frameLen});
-    
-    // Запись заголовка чанка
-    file.write((uint8_t*)"00dc", 4);
-    
-    // Расчет выравнивания (padding)
-    uint32_t rem = frameLen % 4;
-    uint32_t pad = (rem == 0) ? 0 : 4 - rem;
-    uint32_t totalLen = frameLen + pad;
-    
-    print_quartet(totalLen, file);
-    
-    // Запись данных
-    file.write(fb->buf, frameLen);
-    
-    // Запись выравнивания
-    for (int i=0; i<pad; i++) file.write(0);
+
+    if (full.frames == 0) {
+      // Размер берем из самого JPEG: с ROI fb->width/height описывают
+      // не окно сенсора, а размер кадра, заданный при инициализации
+      if (!jpeg_get_dimensions(fb->buf, frameLen, &full.width, &full.height)) {
+        full.width = fb->width;
+        full.height = fb->height;
+      }
+    }
+    if (!avi_write_frame(full, fb->buf, frameLen)) {
+      esp_camera_fb_return(fb);
+      Serial.println("Остановка: Индекс кадров заполнен");
+      break;
+    }
+    if (firstFrameMillis == 0) {
+      firstFrameMillis = millis();
+      Serial.printf("Первый кадр через %lu мс после старта\n", firstFrameMillis);
+    }
+
+    // Прокси: каждый PROXY_FRAME_DIVIDER-й кадр копируется кодировщику на ядре 0,
+    // который уменьшает его и пишет во второй файл
+    if (!proxyFailed && (full.frames - 1) % PROXY_FRAME_DIVIDER == 0) {
+      if (!proxyActive) {
+        proxyActive = avi_open(proxy, SD_MMC, proxyName, fps / PROXY_FRAME_DIVIDER,
+                               proxyIdx, maxProxyFrames);
+        if (proxyActive && !proxyBegin(full.width, full.height, PROXY_SCALE, PROXY_JPEG_QUALITY, proxy)) {
+          proxy.file.close();
+          SD_MMC.remove(proxy.path);
+          proxyActive = false;
+        }
+        proxyFailedLast = !proxyActive;
+        if (!proxyActive) {
+          proxyFailed = true;
+          Serial.println("Прокси отключен: не хватает памяти или ошибка SD");
+        }
+      }
+
+      if (proxyActive) proxySubmit(fb->buf, frameLen);
+    }
     
     esp_camera_fb_return(fb);
     
-    frames++;
-    frames_size += (8 + totalLen);
-    current_movi_offset += (8 + totalLen);
-    
     // Проверка размера
-    if (file.size() > (MAX_FILE_SIZE_MB * 1024 * 1024)) {
+    if (full.file.size() > (MAX_FILE_SIZE_MB * 1024 * 1024)) {
       Serial.println("Остановка: Достигнут макс. размер файла");
       break;
     }
     
-    if (frames % 50 == 0) {
-      file.flush(); // Ensure data is written and size updated
+    if (full.frames % 50 == 0) {
+      full.file.flush(); // Ensure data is written and size updated
       Serial.printf("Rec: %d frames | %d s | %.2f MB | Heap: %u | Last Frame: %u B\n", 
-        frames, (millis()-startTime)/1000, file.size()/1024.0/1024.0, ESP.getFreeHeap(), frameLen);
+        full.frames, (millis()-startTime)/1000, full.file.size()/1024.0/1024.0, ESP.getFreeHeap(), frameLen);
     }
     yield();
   }
@@ -136,48 +258,63 @@ String recordVideo(int recordDuration, int fps, String ssid, String password) {
   // Завершение AVI файла
   digitalWrite(LED_GPIO_NUM, HIGH); // Выключить LED
   
-  // Переподключение WiFi если нужно (он должен быть включен)
+  // Ожидание WiFi перед отправкой (переподключение идет в фоне, см. wifiService)
   if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi потерян. Переподключение...");
-      WiFi.mode(WIFI_STA);
-      WiFi.begin(ssid.c_str(), password.c_str());
+      Serial.println("WiFi не подключен. Ожидание...");
       unsigned long wifiWait = millis();
-      while (WiFi.status() != WL_CONNECTED && millis() - wifiWait < 20000) {
+      while (WiFi.status() != WL_CONNECTED && millis() - wifiWait < WIFI_CONNECT_TIMEOUT_MS) {
+        wifiService();
         delay(500);
         Serial.print(".");
       }
-      Serial.println("\nWiFi подключен.");
+      wifiService();
+      Serial.println();
   }
   
   client.setInsecure(); // Обновление SSL контекста
   
-  if (file.size() < avi_header_size) {
-    logToBot("Ошибка: Файл слишком мал (" + String(file.size()) + " байт). Запись не удалась.");
-    file.close();
-    return "";
+  if (full.file.size() < avi_header_size || full.frames == 0) {
+    logToBotf("Ошибка: Файл слишком мал (%u байт). Запись не удалась.", (unsigned)full.file.size());
+    full.file.close();
+    if (proxyActive) {
+      proxyEnd();
+      proxy.file.close();
+      SD_MMC.remove(proxy.path);
+    }
+    return clip;
   }
   
   unsigned long duration = (millis() - startTime) / 1000;
-  float actual_fps = (duration > 0) ? (float)frames / duration : fps;
-  
-  String stats = "Готово. F:" + String(frames) + " T:" + String(duration) + "с FPS:" + String(actual_fps, 1) + " Размер:" + String(file.size()/1024.0/1024.0, 2) + "MB";
-  logToBot(stats);
-  
-  // Запись индекса (idx1)
-  file.write((uint8_t*)"idx1", 4);
-  uint32_t idx_size = idx.size() * 16;
-  print_quartet(idx_size, file);
+  float actual_fps = (duration > 0) ? (float)full.frames / duration : fps;
   
-  for (const auto& entry : idx) {
-    file.write((uint8_t*)"00dc", 4);
-    print_quartet(16, file); // Flags: 0x10 (AVIIF_KEYFRAME)
-    print_quartet(entry.offset, file);
-    print_quartet(entry.size, file);
+  char stats[LOG_MSG_MAX];
+  int len = snprintf(stats, sizeof(stats), "Готово. F:%d T:%luс FPS:%.1f Размер:%.2fMB",
+                     full.frames, duration, actual_fps, full.file.size() / 1024.0 / 1024.0);
+
+  avi_close(full, actual_fps);
+  strlcpy(clip.fullPath, filename, sizeof(clip.fullPath));
+  clip.uploadBytes = full.frames_size;
+  clip.uploadPixels = (double)full.frames * full.width * full.height;
+
+  if (proxyActive) {
+    proxyEnd(); // Дожидаемся кадров, еще стоящих в очереди кодировщика
+    const ProxyStats &ps = proxyStats();
+    float proxy_fps = (duration > 0) ? (float)proxy.frames / duration : fps / PROXY_FRAME_DIVIDER;
+    avi_close(proxy, proxy_fps);
+
+    if (ps.frames > 0) {
+      strlcpy(clip.proxyPath, proxy.path, sizeof(clip.proxyPath));
+      clip.uploadBytes = proxy.frames_size;
+      clip.uploadPixels = (double)proxy.frames * proxy.width * proxy.height;
+      snprintf(stats + len, sizeof(stats) - len,
+               "\nПрокси: %dx%d F:%d Пропущено:%d CPU:%.1fмс/кадр Размер кадра:%.0f%%",
+               ps.width, ps.height, ps.frames, ps.dropped, ps.encodeMicros / 1000.0 / ps.frames,
+               100.0 * ps.proxyBytes / ps.sourceBytes);
+    } else {
+      SD_MMC.remove(proxy.path);
+    }
   }
-  
-  // Обновление заголовка
-  write_avi_header(file, buf, frames, 320, 240, actual_fps, frames_size);
-  
-  file.close();
-  return filename;
+
+  logToBot(stats);
+  return clip;
 }
@@ -2,8 +2,26 @@
 #define VIDEO_RECORDER_H
 
 #include <Arduino.h>
+#include <Preferences.h>
 #include "esp_camera.h"
 
-String recordVideo(int recordDuration, int fps, String ssid, String password);
+// Результат одного цикла записи
+struct RecordedClip {
+  char fullPath[32] = "";   // Полное разрешение, остается на SD карте ("" при ошибке)
+  char proxyPath[32] = "";  // Уменьшенная копия для отправки ("" если прокси выключен)
+  uint32_t uploadBytes = 0;  // Объем кадров в отправляемом файле (для модели планировщика)
+  double uploadPixels = 0;   // Сумма пикселей всех кадров отправляемого файла
+
+  // Файл, который отправляется в Telegram по умолчанию
+  const char* uploadPath() const { return proxyPath[0] ? proxyPath : fullPath; }
+  bool proxyUsed() const { return proxyPath[0] != 0; }
+};
+
+extern unsigned long firstFrameMillis; // Время первого кадра после старта (0 = еще не было)
+
+void recorderBegin(Preferences &prefs);
+RecordedClip recordVideo(int recordDuration, int fps);
+bool recorderProxyAvailable();
+void pruneOldRecordings();
 
 #endif
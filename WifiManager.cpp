@@ -2,11 +2,25 @@
 #include <DNSServer.h>
 #include <WebServer.h>
 #include "Config.h"
+#include "TelegramManager.h"
+#include "VideoRecorder.h"
 
 // Глобальные переменные для Captive Portal (внутренние для этого модуля)
 DNSServer dnsServer;
 WebServer server(80);
 
+// Состояние подключения к WiFi (внутреннее для этого модуля)
+enum WifiState { WIFI_IDLE, WIFI_FAST, WIFI_SCAN, WIFI_UP };
+static WifiState wifiState = WIFI_IDLE;
+static Preferences *wifiPrefs = nullptr;
+static String wifiSsid = "";
+static String wifiPass = "";
+static unsigned long attemptStart = 0;
+static bool everConnected = false;
+static bool usedFastPath = false;
+static bool bootReportPending = false;
+static unsigned long firstConnectMillis = 0;
+
 void startCaptivePortal(Preferences &prefs) {
   Serial.println("Запуск Captive Portal...");
   WiFi.disconnect();
@@ -31,6 +45,11 @@ void startCaptivePortal(Preferences &prefs) {
     html += "<form action='/save' method='POST'>";
     html += "<input type='text' name='s' placeholder='Имя сети (SSID)' required><br>";
     html += "<input type='password' name='p' placeholder='Пароль'><br>";
+    html += "<p>Статический IP (необязательно, ускоряет подключение):</p>";
+    html += "<input type='text' name='ip' placeholder='IP, например 192.168.1.50'><br>";
+    html += "<input type='text' name='gw' placeholder='Шлюз'><br>";
+    html += "<input type='text' name='mask' placeholder='Маска (255.255.255.0)'><br>";
+    html += "<input type='text' name='dns' placeholder='DNS'><br>";
     html += "<input type='submit' value='Сохранить и подключиться'>";
     html += "</form></body></html>";
     server.send(200, "text/html", html);
@@ -45,6 +64,13 @@ void startCaptivePortal(Preferences &prefs) {
     if (s.length() > 0) {
       prefs.putString("ssid", s);
       prefs.putString("pass", p);
+      prefs.putString("ip", server.arg("ip"));
+      prefs.putString("gw", server.arg("gw"));
+      prefs.putString("mask", server.arg("mask"));
+      prefs.putString("dns", server.arg("dns"));
+      // Новая сеть - сохраненные BSSID/канал больше не актуальны
+      prefs.remove("bssid");
+      prefs.remove("chan");
       
       String html = "<html><head><meta name='viewport' content='width=device-width, initial-scale=1.0, user-scalable=no'><meta charset='UTF-8'></head><body>";
       html += "<h2>Сохранено!</h2><p>Перезагрузка...</p></body></html>";
@@ -79,3 +105,121 @@ void startCaptivePortal(Preferences &prefs) {
     yield();
   }
 }
+
+// Запуск подключения к WiFi без ожидания (подключение идет в фоне)
+// Если есть сохраненные BSSID и канал, пропускаем сканирование эфира.
+// Если задан статический IP, пропускаем DHCP.
+void wifiBeginFast(Preferences &prefs, const String &ssid, const String &password) {
+  wifiPrefs = &prefs;
+  wifiSsid = ssid;
+  wifiPass = password;
+
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
+
+  IPAddress ip, gw, mask, dns;
+  if (ip.fromString(prefs.getString("ip", "")) && gw.fromString(prefs.getString("gw", ""))) {
+    if (!mask.fromString(prefs.getString("mask", ""))) mask = IPAddress(255, 255, 255, 0);
+    if (!dns.fromString(prefs.getString("dns", ""))) dns = gw;
+    WiFi.config(ip, gw, mask, dns);
+    Serial.println("WiFi: статический IP " + ip.toString());
+  }
+
+  uint8_t bssid[6];
+  int32_t channel = prefs.getInt("chan", 0);
+  usedFastPath = prefs.getBytes("bssid", bssid, sizeof(bssid)) == sizeof(bssid) && channel > 0;
+
+  Serial.printf("Подключение к WiFi: %s (%s)...\n", ssid.c_str(), usedFastPath ? "сохраненный BSSID" : "поиск");
+  if (usedFastPath) {
+    WiFi.begin(ssid.c_str(), password.c_str(), channel, bssid);
+    wifiState = WIFI_FAST;
+  } else {
+    WiFi.begin(ssid.c_str(), password.c_str());
+    wifiState = WIFI_SCAN;
+  }
+  attemptStart = millis();
+}
+
+// Сохранение BSSID/канала точки доступа (только при изменении, чтобы не изнашивать flash)
+static void cacheAccessPoint() {
+  uint8_t saved[6];
+  uint8_t *bssid = WiFi.BSSID();
+  int32_t channel = WiFi.channel();
+  if (!bssid) return;
+
+  if (wifiPrefs->getBytes("bssid", saved, sizeof(saved)) != sizeof(saved) ||
+      memcmp(saved, bssid, sizeof(saved)) != 0) {
+    wifiPrefs->putBytes("bssid", bssid, 6);
+  }
+  if (wifiPrefs->getInt("chan", 0) != channel) {
+    wifiPrefs->putInt("chan", channel);
+  }
+}
+
+// Обслуживание подключения. Вызывать часто (из loop() и из цикла записи).
+// Возвращает true один раз при каждом (пере)подключении.
+bool wifiService() {
+  if (wifiState == WIFI_IDLE) return false;
+
+  bool connected = WiFi.status() == WL_CONNECTED;
+
+  if (wifiState == WIFI_UP) {
+    if (!connected) {
+      Serial.println("WiFi потерян, ожидание переподключения...");
+      wifiState = WIFI_SCAN; // Переподключение выполняет сам драйвер (autoReconnect)
+      attemptStart = millis();
+    }
+    return false;
+  }
+
+  if (!connected) {
+    // Сохраненная точка доступа не ответила - переходим к обычному поиску
+    if (wifiState == WIFI_FAST && millis() - attemptStart > WIFI_FAST_CONNECT_TIMEOUT_MS) {
+      Serial.println("WiFi: быстрое подключение не удалось, полный поиск...");
+      usedFastPath = false;
+      WiFi.disconnect();
+      WiFi.begin(wifiSsid.c_str(), wifiPass.c_str());
+      wifiState = WIFI_SCAN;
+    }
+    return false;
+  }
+
+  wifiState = WIFI_UP;
+  Serial.print("WiFi подключен. IP адрес: ");
+  Serial.println(WiFi.localIP());
+  cacheAccessPoint();
+
+  // Настройка безопасного клиента для Telegram (без проверки сертификата)
+  client.setInsecure();
+  client.setHandshakeTimeout(30000); // Тайм-аут рукопожатия 30 сек
+
+  if (!everConnected) {
+    everConnected = true;
+    // Сообщение о запуске отправляет wifiSendBootReport() из loop():
+    // здесь мы можем быть внутри цикла записи, а отправка блокирует на время TLS
+    bootReportPending = true;
+    firstConnectMillis = millis();
+    if (chatId == "") {
+      Serial.println("ChatID не установлен. Отправьте /start боту.");
+    }
+  }
+  return true;
+}
+
+// Отчет о времени запуска после первого подключения. Вызывать вне цикла записи
+void wifiSendBootReport() {
+  if (!bootReportPending || WiFi.status() != WL_CONNECTED) return;
+  bootReportPending = false;
+
+  char frameInfo[64] = "Запись не активна";
+  if (firstFrameMillis > 0) {
+    snprintf(frameInfo, sizeof(frameInfo), "Первый кадр: %lu мс после старта", firstFrameMillis);
+  }
+  logToBotf("Бот запущен. Готов к работе.\nWiFi: %lu мс после старта (%s)\n%s",
+            firstConnectMillis, usedFastPath ? "быстрое подключение" : "полный поиск", frameInfo);
+}
+
+// Подключиться ни разу не удалось за WIFI_CONNECT_TIMEOUT_MS
+bool wifiFailed() {
+  return !everConnected && wifiState != WIFI_IDLE && millis() - attemptStart > WIFI_CONNECT_TIMEOUT_MS;
+}
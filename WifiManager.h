@@ -7,4 +7,9 @@
 
 void startCaptivePortal(Preferences &prefs);
 
+void wifiBeginFast(Preferences &prefs, const String &ssid, const String &password);
+bool wifiService();
+bool wifiFailed();
+void wifiSendBootReport();
+
 #endif
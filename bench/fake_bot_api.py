@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""Локальная заглушка Telegram Bot API для замеров отправки и команд.
+
+Поддерживает подмножество методов, которые использует прошивка:
+getUpdates, sendMessage (в том числе с reply_markup, как делает
+sendMessageWithReplyKeyboard) и sendVideo (multipart/form-data или JSON
+с file_id ранее загруженного видео).
+
+Условия канала задаются параметрами командной строки:
+  --bandwidth-kbps  ограничение скорости приема тела запроса (0 = без ограничения)
+  --latency-ms      задержка перед каждым ответом
+  --fail-rate       доля запросов sendVideo, на которые приходит ошибка 500
+  --drop-rate       доля запросов sendVideo, в которых соединение рвется посреди загрузки
+
+Служебные методы (без токена):
+  POST /__inject   {"text": "...", "chat_id": 1001}  - добавить входящее сообщение
+  GET  /__stats                                       - счетчики запросов и байт
+"""
+
+import argparse
+import json
+import random
+import socket
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+RCVBUF_BYTES = 16 * 1024  # Буфер приема сокета заглушки (порядка окна TCP на плате)
+
+
+class BotState:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.updates = []
+        self.next_update_id = 1
+        self.next_message_id = 1
+        self.next_file_id = 1
+        self.stats = {
+            "getUpdates": 0,
+            "sendMessage": 0,
+            "sendVideo": 0,
+            "sendVideo_by_file_id": 0,
+            "video_bytes": 0,
+            "failed": 0,
+            "dropped": 0,
+        }
+        self.messages = []
+
+    def count(self, key, n=1):
+        with self.lock:
+            self.stats[key] = self.stats.get(key, 0) + n
+
+    def inject(self, text, chat_id):
+        with self.lock:
+            self.updates.append({
+                "update_id": self.next_update_id,
+                "message": {
+                    "message_id": self.next_message_id,
+                    "from": {"id": chat_id, "first_name": "bench"},
+                    "chat": {"id": chat_id, "type": "private"},
+                    "date": int(time.time()),
+                    "text": text,
+                },
+            })
+            self.next_update_id += 1
+            self.next_message_id += 1
+
+    def take_updates(self, offset, limit):
+        with self.lock:
+            # Как в Telegram: offset подтверждает все обновления с меньшим id
+            self.updates = [u for u in self.updates if u["update_id"] >= offset]
+            return self.updates[:limit]
+
+    def new_message_id(self):
+        with self.lock:
+            mid = self.next_message_id
+            self.next_message_id += 1
+            return mid
+
+    def new_file_id(self):
+        with self.lock:
+            fid = "BAACAgIAAxkBAAI%06d" % self.next_file_id
+            self.next_file_id += 1
+            return fid
+
+
+def make_handler(state, args):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_message(self, fmt, *a):
+            if args.verbose:
+                super().log_message(fmt, *a)
+
+        # --- Ответы ---
+
+        def reply(self, code, payload):
+            if args.latency_ms:
+                time.sleep(args.latency_ms / 1000.0)
+            # Компактный JSON без экранирования UTF-8, как у api.telegram.org
+            body = json.dumps(payload, ensure_ascii=False, separators=(",", ":")).encode()
+            self.send_response(code)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.send_header("Connection", "close")
+            self.end_headers()
+            self.wfile.write(body)
+            self.close_connection = True
+
+        def ok(self, result):
+            self.reply(200, {"ok": True, "result": result})
+
+        def error(self, code, description):
+            self.reply(code, {"ok": False, "error_code": code, "description": description})
+
+        # --- Чтение тела с ограничением скорости ---
+
+        def read_body(self, drop_at=None):
+            length = int(self.headers.get("Content-Length", 0))
+            rate = args.bandwidth_kbps * 1024
+            chunk = 16 * 1024
+            data = bytearray()
+            start = time.monotonic()
+            while len(data) < length:
+                if drop_at is not None and len(data) >= drop_at:
+                    return None
+                part = self.rfile.read(min(chunk, length - len(data)))
+                if not part:
+                    return None
+                data += part
+                if rate:
+                    # Досыпаем, чтобы средняя скорость не превышала rate
+                    ahead = len(data) / rate - (time.monotonic() - start)
+                    if ahead > 0:
+                        time.sleep(ahead)
+            return bytes(data)
+
+        # --- Маршрутизация ---
+
+        def route(self):
+            url = urlparse(self.path)
+            parts = url.path.strip("/").split("/")
+            if len(parts) == 2 and parts[0].startswith("bot"):
+                return parts[1], parse_qs(url.query)
+            return url.path, parse_qs(url.query)
+
+        def do_GET(self):
+            method, query = self.route()
+            if method == "/__stats":
+                with state.lock:
+                    self.ok(dict(state.stats))
+            elif method == "getUpdates":
+                state.count("getUpdates")
+                offset = int(query.get("offset", ["0"])[0])
+                limit = int(query.get("limit", ["100"])[0])
+                self.ok(state.take_updates(offset, limit))
+            else:
+                self.error(404, "Not Found: method not found")
+
+        def do_POST(self):
+            method, query = self.route()
+            ctype = self.headers.get("Content-Type", "")
+
+            if method == "/__inject":
+                req = json.loads(self.read_body() or b"{}")
+                state.inject(req.get("text", ""), req.get("chat_id", 1001))
+                self.ok(True)
+            elif method == "getUpdates":
+                state.count("getUpdates")
+                req = json.loads(self.read_body() or b"{}")
+                self.ok(state.take_updates(int(req.get("offset", 0)), int(req.get("limit", 100))))
+            elif method == "sendMessage":
+                state.count("sendMessage")
+                req = json.loads(self.read_body() or b"{}")
+                self.ok({
+                    "message_id": state.new_message_id(),
+                    "chat": {"id": req.get("chat_id")},
+                    "date": int(time.time()),
+                    "text": req.get("text", ""),
+                })
+            elif method == "sendVideo" and ctype.startswith("application/json"):
+                # Повторная отправка по file_id - без загрузки файла
+                state.count("sendVideo_by_file_id")
+                req = json.loads(self.read_body() or b"{}")
+                self.ok(self.video_result(req.get("chat_id"), req.get("video"), 0))
+            elif method == "sendVideo":
+                self.send_video(ctype)
+            else:
+                self.read_body()
+                self.error(404, "Not Found: method not found")
+
+        def send_video(self, ctype):
+            state.count("sendVideo")
+            length = int(self.headers.get("Content-Length", 0))
+            drop_at = None
+            if random.random() < args.drop_rate:
+                drop_at = random.randint(0, max(length - 1, 0))
+
+            body = self.read_body(drop_at)
+            if body is None:
+                state.count("dropped")
+                self.close_connection = True
+                return
+
+            fields = parse_multipart(body, ctype)
+            video = fields.get("video", b"")
+            state.count("video_bytes", len(video))
+
+            if random.random() < args.fail_rate:
+                state.count("failed")
+                self.error(500, "Internal Server Error: injected failure")
+                return
+            if "chat_id" not in fields or not video:
+                self.error(400, "Bad Request: there is no video in the request")
+                return
+            self.ok(self.video_result(fields["chat_id"].decode(), state.new_file_id(), len(video)))
+
+        def video_result(self, chat_id, file_id, size):
+            # Как у api.telegram.org: у превью свой file_id, и он идет раньше file_id видео
+            return {
+                "message_id": state.new_message_id(),
+                "chat": {"id": chat_id},
+                "date": int(time.time()),
+                "video": {
+                    "duration": 0,
+                    "width": 320,
+                    "height": 240,
+                    "thumbnail": {
+                        "file_id": "AAMCAgADGQEthumb" + str(file_id)[-6:],
+                        "file_unique_id": "AQADthumb",
+                        "width": 320,
+                        "height": 240,
+                    },
+                    "file_id": file_id,
+                    "file_unique_id": "AgAD" + str(file_id)[-6:],
+                    "mime_type": "video/x-msvideo",
+                    "file_size": size,
+                },
+            }
+
+    return Handler
+
+
+def parse_multipart(body, ctype):
+    """Разбор multipart/form-data: имя поля -> содержимое (bytes)."""
+    marker = "boundary="
+    if marker not in ctype:
+        return {}
+    boundary = ("--" + ctype.split(marker, 1)[1].strip().strip('"')).encode()
+    fields = {}
+    for part in body.split(boundary)[1:]:
+        if part.startswith(b"--"):
+            break
+        head, _, content = part.partition(b"\r\n\r\n")
+        if content.endswith(b"\r\n"):
+            content = content[:-2]
+        for line in head.decode(errors="replace").split("\r\n"):
+            if line.lower().startswith("content-disposition") and 'name="' in line:
+                name = line.split('name="', 1)[1].split('"', 1)[0]
+                fields[name] = content
+    return fields
+
+
+class SmallBufferServer(ThreadingHTTPServer):
+    """Небольшой буфер приема (наследуется принятыми соединениями): иначе ядро
+    принимает сотни КБ тела запроса раньше, чем их прочитает ограничитель скорости."""
+
+    def server_bind(self):
+        self.socket.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, RCVBUF_BYTES)
+        super().server_bind()
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--host", default="127.0.0.1")
+    p.add_argument("--port", type=int, default=8081)
+    p.add_argument("--bandwidth-kbps", type=float, default=0)
+    p.add_argument("--latency-ms", type=float, default=0)
+    p.add_argument("--fail-rate", type=float, default=0)
+    p.add_argument("--drop-rate", type=float, default=0)
+    p.add_argument("--seed", type=int, default=None)
+    p.add_argument("--verbose", action="store_true")
+    args = p.parse_args()
+
+    random.seed(args.seed)
+    server = SmallBufferServer((args.host, args.port), make_handler(BotState(), args))
+    print("Заглушка Bot API: http://%s:%d (bandwidth=%g KB/s, latency=%g ms, fail=%g, drop=%g)" % (
+        args.host, args.port, args.bandwidth_kbps, args.latency_ms, args.fail_rate, args.drop_rate), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,209 @@
+// Бенчмарк отправки видео и команд бота против локальной заглушки Bot API.
+// Собирает настоящие TelegramManager.cpp, Uploader.cpp и MemoryPool.cpp
+// с заменами Arduino API из bench/shims (см. bench/README.md).
+#include "Arduino.h"
+#include "Config.h"
+#include "CapturePlanner.h"
+#include "MemoryPool.h"
+#include "TelegramManager.h"
+#include "SD_MMC.h"
+#include "Uploader.h"
+
+#include <algorithm>
+#include <vector>
+
+struct BenchOptions {
+  const char* file = nullptr;  // Готовый файл для отправки (иначе генерируется)
+  double sizeMb = 5;
+  int uploads = 3;
+  int maxRetries = 3;
+  int commands = 20;
+  int recipients = 0;          // Дополнительные получатели (рассылка по file_id)
+};
+
+static void usage() {
+  fprintf(stderr,
+    "Использование: host_bench [--file ПУТЬ] [--size-mb N] [--uploads N] [--retries N] [--commands N]\n"
+    "                  [--recipients N]\n"
+    "Заглушка должна быть запущена на %s:%d (python3 fake_bot_api.py)\n",
+    TELEGRAM_API_HOST, TELEGRAM_API_PORT);
+}
+
+// Файл со случайным содержимым в "корне SD" (текущем каталоге)
+static bool makeTestFile(const char* path, double sizeMb) {
+  File f = SD_MMC.open(path, FILE_WRITE);
+  if (!f) return false;
+  uint8_t block[4096];
+  size_t total = (size_t)(sizeMb * 1024 * 1024);
+  for (size_t done = 0; done < total; done += sizeof(block)) {
+    for (size_t i = 0; i < sizeof(block); i++) block[i] = rand();
+    f.write(block, std::min(sizeof(block), total - done));
+  }
+  f.close();
+  return true;
+}
+
+// Служебный запрос к заглушке: добавить входящее сообщение
+static bool injectMessage(const char* text) {
+  WiFiClientSecure c;
+  if (!c.connect(TELEGRAM_API_HOST, TELEGRAM_API_PORT)) return false;
+  char json[256];
+  int len = snprintf(json, sizeof(json), "{\"text\":\"%s\",\"chat_id\":%s}", text, chatId.c_str());
+  c.print("POST /__inject HTTP/1.1\r\n");
+  c.printf("Host: %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+           TELEGRAM_API_HOST, len);
+  c.print(json);
+  char body[256];
+  return readHttpResponse(c, body, sizeof(body), 5000) == 200;
+}
+
+// Счетчик заглушки из /__stats (0, если недоступен)
+static long long stubStat(const char* key) {
+  WiFiClientSecure c;
+  if (!c.connect(TELEGRAM_API_HOST, TELEGRAM_API_PORT)) return 0;
+  c.printf("GET /__stats HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", TELEGRAM_API_HOST);
+  char body[512];
+  if (readHttpResponse(c, body, sizeof(body), 5000) != 200) return 0;
+  char pattern[48];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  const char* p = strstr(body, pattern);
+  return p ? atoll(p + strlen(pattern)) : 0;
+}
+
+// Команда боту от имени основного чата: сообщение -> getUpdates -> обработка
+static bool runCommand(const char* text, bool &isRecordingActive, int &recordDuration, int &fps,
+                       int &jpegQuality, framesize_t &frameSize, int &flashBrightness, RoiWindow &roi,
+                       Preferences &prefs) {
+  if (!injectMessage(text)) return false;
+  int n = 0;
+  for (int poll = 0; poll < 10 && n == 0; poll++) {
+    n = bot.getUpdates(bot.last_message_received + 1);
+  }
+  if (n > 0) {
+    handleNewMessages(n, isRecordingActive, recordDuration, fps, jpegQuality, frameSize, flashBrightness, roi, prefs);
+  }
+  return n > 0;
+}
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5));
+  return v[i];
+}
+
+int main(int argc, char** argv) {
+  BenchOptions opt;
+  for (int i = 1; i < argc; i++) {
+    auto next = [&]() { return i + 1 < argc ? argv[++i] : ""; };
+    if (!strcmp(argv[i], "--file")) opt.file = next();
+    else if (!strcmp(argv[i], "--size-mb")) opt.sizeMb = atof(next());
+    else if (!strcmp(argv[i], "--uploads")) opt.uploads = atoi(next());
+    else if (!strcmp(argv[i], "--retries")) opt.maxRetries = atoi(next());
+    else if (!strcmp(argv[i], "--commands")) opt.commands = atoi(next());
+    else if (!strcmp(argv[i], "--recipients")) opt.recipients = atoi(next());
+    else { usage(); return 2; }
+  }
+
+  // Каталог клипов (CATALOG_PATH в bench/build) остался бы от прошлого запуска:
+  // он растет и меняет, какой клип отправит "/send 1"
+  SD_MMC.remove(CATALOG_PATH);
+
+  // Состояние прошивки, как после setup()
+  initMemoryPools();
+  chatId = "1001";
+  bool isRecordingActive = false;
+  int recordDuration = DEFAULT_RECORD_DURATION;
+  int fps = DEFAULT_FPS;
+  int jpegQuality = DEFAULT_JPEG_QUALITY;
+  framesize_t frameSize = DEFAULT_FRAME_SIZE;
+  int flashBrightness = DEFAULT_FLASH_BRIGHTNESS;
+  RoiWindow roi;
+  Preferences prefs;
+
+  printf("Bot API: http://%s:%d\n", TELEGRAM_API_HOST, TELEGRAM_API_PORT);
+
+  // Получатели рассылки добавляются той же командой, что и с телефона
+  for (int r = 0; r < opt.recipients; r++) {
+    char cmd[48];
+    snprintf(cmd, sizeof(cmd), "/addchat %d", 2001 + r);
+    if (!runCommand(cmd, isRecordingActive, recordDuration, fps, jpegQuality, frameSize, flashBrightness, roi, prefs)) {
+      fprintf(stderr, "Не удалось добавить получателя\n");
+      return 1;
+    }
+  }
+  long long bytesBefore = stubStat("video_bytes");
+  long long byIdBefore = stubStat("sendVideo_by_file_id");
+
+  // --- Отправка видео ---
+  char path[64] = "/bench_upload.bin";
+  if (opt.file) {
+    snprintf(path, sizeof(path), "/%s", opt.file);
+  } else if (!makeTestFile(path, opt.sizeMb)) {
+    fprintf(stderr, "Не удалось создать тестовый файл\n");
+    return 1;
+  }
+  File probe = SD_MMC.open(path, FILE_READ);
+  size_t fileSize = probe.size();
+  probe.close();
+
+  // Скорость - по передаче тела файла (UploadResult), без сообщений в лог
+  // и рассылки по file_id, которые тоже идут внутри sendVideoToTelegram()
+  int ok = 0, retries = 0, failed = 0;
+  double totalSec = 0;
+  std::vector<double> rates;
+  for (int u = 0; u < opt.uploads; u++) {
+    for (int attempt = 0; attempt <= opt.maxRetries; attempt++) {
+      if (attempt > 0) retries++;
+      bool sent = sendVideoToTelegram(path);
+      if (sent) {
+        double sec = std::max(lastUploadResult().elapsedMs, 1UL) / 1000.0;
+        ok++;
+        totalSec += sec;
+        rates.push_back(fileSize / 1024.0 / 1024.0 / sec);
+        break;
+      }
+      if (attempt == opt.maxRetries) failed++;
+    }
+  }
+  if (!opt.file) SD_MMC.remove(path);
+  long long uploadedBytes = stubStat("video_bytes") - bytesBefore;
+  long long byFileId = stubStat("sendVideo_by_file_id") - byIdBefore;
+
+  printf("\nОтправка: %d x %.2f MB\n", opt.uploads, fileSize / 1024.0 / 1024.0);
+  printf("  успешно: %d, повторов: %d, неудач: %d\n", ok, retries, failed);
+  if (ok > 0) {
+    printf("  MB/s: среднее %.2f, мин %.2f, макс %.2f\n",
+           ok * fileSize / 1024.0 / 1024.0 / totalSec, percentile(rates, 0), percentile(rates, 1));
+  }
+  printf("  получателей: %d, загружено в заглушку: %.2f MB, пересылок по file_id: %lld\n",
+         opt.recipients + 1, uploadedBytes / 1024.0 / 1024.0, byFileId);
+
+  // --- Задержка команд: сообщение -> getUpdates -> обработка -> ответ ---
+  static const char* commands[] = { "/status", "/fps 15", "/duration 60", "/flash 0", "/clips", "/send 1" };
+  std::vector<double> latencies;
+  for (int i = 0; i < opt.commands; i++) {
+    const char* cmd = commands[i % (sizeof(commands) / sizeof(commands[0]))];
+    unsigned long t0 = micros();
+    if (runCommand(cmd, isRecordingActive, recordDuration, fps, jpegQuality, frameSize, flashBrightness, roi, prefs)) {
+      latencies.push_back((micros() - t0) / 1000.0);
+    }
+  }
+
+  printf("\nКоманды: %u из %d\n", (unsigned)latencies.size(), opt.commands);
+  if (!latencies.empty()) {
+    printf("  задержка, мс: p50 %.1f, p95 %.1f, макс %.1f\n",
+           percentile(latencies, 0.5), percentile(latencies, 0.95), percentile(latencies, 1));
+  }
+
+  // Решение планировщика для следующего клипа по измеренной скорости
+  char plan[256];
+  planCapture(recordDuration, fps, jpegQuality, frameSize, roi, PROXY_ENABLED); // Как на плате с PSRAM
+  formatCaptureStatus(plan, sizeof(plan));
+  printf("\n%s\n", plan);
+
+  char mem[256];
+  formatMemoryStats(mem, sizeof(mem));
+  printf("\n%s\n", mem);
+  return failed > 0 ? 1 : 0;
+}
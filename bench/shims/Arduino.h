@@ -0,0 +1,122 @@
+// Минимальная замена Arduino API для сборки модулей на ПК (см. bench/README.md).
+// Реализовано только то, что используют TelegramManager, Uploader и MemoryPool.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <strings.h>
+#include <string>
+
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+template <typename T, typename L, typename H>
+T constrain(T x, L lo, H hi) { return x < (T)lo ? (T)lo : (x > (T)hi ? (T)hi : x); }
+
+void ledcWrite(uint8_t pin, uint32_t duty);
+
+// strlcpy есть в newlib (ESP32) и macOS, а в glibc - только с версии 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+#define HOST_NEEDS_STRLCPY 1
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+// ------------------------------------------
+// String
+// ------------------------------------------
+class String {
+ public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  String(const String& s) = default;
+  explicit String(char c) : _s(1, c) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+  explicit String(long v) : _s(std::to_string(v)) {}
+  explicit String(unsigned int v) : _s(std::to_string(v)) {}
+  explicit String(unsigned long v) : _s(std::to_string(v)) {}
+  String(double v, int digits);
+
+  String& operator=(const String& s) = default;
+  String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.size(); }
+
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator==(const char* o) const { return _s == (o ? o : ""); }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* o) const { return !(*this == o); }
+
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o) { _s += o; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b._s); }
+
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+
+  bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+  bool endsWith(const String& p) const {
+    return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+  }
+  int indexOf(const String& p) const { size_t i = _s.find(p._s); return i == std::string::npos ? -1 : (int)i; }
+  int indexOf(char c) const { size_t i = _s.find(c); return i == std::string::npos ? -1 : (int)i; }
+  String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < _s.size() && to > from ? String(_s.substr(from, to - from)) : String();
+  }
+  long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+  void trim();
+
+ private:
+  std::string _s;
+};
+
+// ------------------------------------------
+// Print / Serial
+// ------------------------------------------
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) { return write(&c, 1); }
+  virtual size_t write(const uint8_t* buf, size_t size) = 0;
+
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HostSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  size_t write(const uint8_t* buf, size_t size) override;
+  using Print::write;
+};
+extern HostSerial Serial;
+
+class HostEsp {
+ public:
+  uint32_t getFreeHeap();
+  void restart() { exit(0); }
+};
+extern HostEsp ESP;
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HOST_CLIENT_H
+#define HOST_CLIENT_H
+
+#include "Arduino.h"
+
+// Базовый класс TCP клиента, как в Arduino (Client : Stream : Print)
+class Client : public Print {
+ public:
+  virtual int connect(const char* host, uint16_t port) = 0;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual uint8_t connected() = 0;
+  virtual void stop() = 0;
+  using Print::write;
+};
+
+#endif
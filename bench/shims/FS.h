@@ -0,0 +1,45 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+// Файл поверх stdio
+class File {
+ public:
+  File() {}
+  explicit File(FILE* f) : _f(f) {}
+
+  explicit operator bool() const { return _f != nullptr; }
+  size_t read(uint8_t* buf, size_t size) { return _f ? fread(buf, 1, size, _f) : 0; }
+  size_t write(const uint8_t* buf, size_t size) { return _f ? fwrite(buf, 1, size, _f) : 0; }
+  bool seek(uint32_t pos) { return _f && fseek(_f, pos, SEEK_SET) == 0; }
+  size_t position() const { return _f ? ftell(_f) : 0; }
+  size_t size() const;
+  int available() const;
+  void close() { if (_f) fclose(_f); _f = nullptr; }
+
+ private:
+  FILE* _f = nullptr;
+};
+
+class FS {
+ public:
+  File open(const char* path, const char* mode = FILE_READ);
+  File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+  bool exists(const char* path);
+  bool remove(const char* path);
+  uint64_t totalBytes();
+  uint64_t usedBytes();
+};
+
+}  // namespace fs
+
+using fs::File;
+
+#endif
@@ -0,0 +1,296 @@
+// Реализация замен Arduino/ESP-IDF для сборки на ПК
+#include "Arduino.h"
+#include "FS.h"
+#include "SD_MMC.h"
+#include "WiFi.h"
+#include "WiFiClientSecure.h"
+#include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+// Таблица разрешений из esp32-camera (порядок как в framesize_t)
+const resolution_info_t resolution[] = {
+  {96, 96}, {160, 120}, {176, 144}, {240, 176}, {240, 240},
+  {320, 240}, {400, 296}, {480, 320}, {640, 480}, {800, 600},
+  {1024, 768}, {1280, 720}, {1280, 1024}, {1600, 1200},
+};
+
+HostSerial Serial;
+HostEsp ESP;
+HostWiFi WiFi;
+HostSDMMC SD_MMC;
+
+// ------------------------------------------
+// Время
+// ------------------------------------------
+static const auto bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void yield() { std::this_thread::yield(); }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void ledcWrite(uint8_t, uint32_t) {}
+
+#ifdef HOST_NEEDS_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size > 0) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+#endif
+
+uint32_t HostEsp::getFreeHeap() { return 0; }
+
+// ------------------------------------------
+// String / Print
+// ------------------------------------------
+String::String(double v, int digits) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  _s = buf;
+}
+
+void String::trim() {
+  size_t b = _s.find_first_not_of(" \t\r\n");
+  size_t e = _s.find_last_not_of(" \t\r\n");
+  _s = (b == std::string::npos) ? std::string() : _s.substr(b, e - b + 1);
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[1024];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+// Лог прошивки идет в stderr (BENCH_QUIET=1 - отключить), отчет бенчмарка - в stdout
+size_t HostSerial::write(const uint8_t* buf, size_t size) {
+  static const bool quiet = getenv("BENCH_QUIET") != nullptr;
+  if (!quiet) fwrite(buf, 1, size, stderr);
+  return size;
+}
+
+// ------------------------------------------
+// Файлы ("SD карта" = текущий каталог)
+// ------------------------------------------
+namespace fs {
+
+size_t File::size() const {
+  struct stat st;
+  return (_f && fstat(fileno(_f), &st) == 0) ? st.st_size : 0;
+}
+
+int File::available() const {
+  if (!_f) return 0;
+  long pos = ftell(_f);
+  return pos < 0 ? 0 : (int)(size() - pos);
+}
+
+File FS::open(const char* path, const char* mode) {
+  // Пути прошивки абсолютные ("/video1.avi") - кладем их в текущий каталог
+  std::string p = std::string(".") + path;
+  const char* m = "rb";
+  if (strcmp(mode, FILE_WRITE) == 0) m = "w+b";
+  else if (strcmp(mode, FILE_APPEND) == 0) m = "ab";
+  else if (strcmp(mode, "r+") == 0) m = "r+b";
+  return File(fopen(p.c_str(), m));
+}
+
+bool FS::exists(const char* path) {
+  std::string p = std::string(".") + path;
+  return access(p.c_str(), F_OK) == 0;
+}
+
+bool FS::remove(const char* path) {
+  std::string p = std::string(".") + path;
+  return ::remove(p.c_str()) == 0;
+}
+
+uint64_t FS::totalBytes() {
+  struct statvfs st;
+  return statvfs(".", &st) == 0 ? (uint64_t)st.f_blocks * st.f_frsize : 0;
+}
+
+uint64_t FS::usedBytes() {
+  struct statvfs st;
+  return statvfs(".", &st) == 0 ? (uint64_t)(st.f_blocks - st.f_bavail) * st.f_frsize : 0;
+}
+
+}  // namespace fs
+
+// ------------------------------------------
+// TCP клиент
+// ------------------------------------------
+static const int HOST_TCP_SNDBUF = 16 * 1024;
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+  stop();
+  signal(SIGPIPE, SIG_IGN);
+
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", port);
+  if (getaddrinfo(host, portStr, &hints, &res) != 0) return 0;
+
+  for (addrinfo* a = res; a; a = a->ai_next) {
+    _fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (_fd < 0) continue;
+    // Буфер отправки как у lwIP на плате. С буфером loopback по умолчанию (мегабайты)
+    // write() возвращается задолго до того, как заглушка прочитала данные, и замеры
+    // скорости и адаптация чанка видят скорость копирования в ядро, а не канала.
+    // Linux удваивает значение, так что фактически буфер ~HOST_TCP_SNDBUF
+    int sndbuf = HOST_TCP_SNDBUF / 2;
+    setsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    if (::connect(_fd, a->ai_addr, a->ai_addrlen) == 0) break;
+    close(_fd);
+    _fd = -1;
+  }
+  freeaddrinfo(res);
+  _eof = false;
+  _rxPos = _rxLen = 0;
+  return _fd >= 0 ? 1 : 0;
+}
+
+size_t WiFiClientSecure::write(const uint8_t* buf, size_t size) {
+  if (_fd < 0) return 0;
+  size_t off = 0;
+  while (off < size) {
+    ssize_t n = send(_fd, buf + off, size - off, 0);
+    if (n <= 0) {
+      stop();
+      break;
+    }
+    off += n;
+  }
+  return off;
+}
+
+// Подкачка данных из сокета в буфер приема
+int WiFiClientSecure::fill(int timeoutMs) {
+  if (_rxPos < _rxLen) return _rxLen - _rxPos;
+  if (_fd < 0 || _eof) return 0;
+  pollfd p = { _fd, POLLIN, 0 };
+  if (poll(&p, 1, timeoutMs) <= 0) return 0;
+  ssize_t n = recv(_fd, _rx, sizeof(_rx), 0);
+  if (n <= 0) {
+    _eof = true;
+    return 0;
+  }
+  _rxPos = 0;
+  _rxLen = n;
+  return n;
+}
+
+int WiFiClientSecure::available() { return fill(0); }
+
+int WiFiClientSecure::read() { return fill(0) > 0 ? _rx[_rxPos++] : -1; }
+
+uint8_t WiFiClientSecure::connected() {
+  fill(0);
+  return _rxPos < _rxLen || (_fd >= 0 && !_eof);
+}
+
+void WiFiClientSecure::stop() {
+  if (_fd >= 0) close(_fd);
+  _fd = -1;
+  _eof = false;
+  _rxPos = _rxLen = 0;
+}
+
+// ------------------------------------------
+// FreeRTOS
+// ------------------------------------------
+struct HostQueue {
+  size_t length;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+  std::mutex m;
+  std::condition_variable cv;
+};
+
+template <typename Pred>
+static bool waitFor(HostQueue* q, std::unique_lock<std::mutex>& lock, TickType_t wait, Pred pred) {
+  if (wait == portMAX_DELAY) {
+    q->cv.wait(lock, pred);
+    return true;
+  }
+  return q->cv.wait_for(lock, std::chrono::milliseconds(wait), pred);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  HostQueue* q = new HostQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(q, lock, wait, [q] { return q->items.size() < q->length; })) return pdFALSE;
+  const uint8_t* p = (const uint8_t*)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(q, lock, wait, [q] { return !q->items.empty(); })) return pdFALSE;
+  if (q->itemSize) memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->m);
+  q->items.clear();
+  q->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg, UBaseType_t,
+                                   TaskHandle_t* handle, BaseType_t) {
+  std::thread(fn, arg).detach();
+  if (handle) *handle = nullptr;
+  return pdPASS;
+}
+
+// Поток завершается сам, когда функция задачи возвращает управление
+void vTaskDelete(TaskHandle_t) {}
@@ -0,0 +1,37 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+// Настройки в памяти процесса (без сохранения между запусками)
+class Preferences {
+ public:
+  bool begin(const char*, bool = false) { return true; }
+  size_t putString(const char* key, const String& v) { _s[key] = v.c_str(); return v.length(); }
+  String getString(const char* key, const String& def = String()) {
+    auto it = _s.find(key); return it == _s.end() ? def : String(it->second);
+  }
+  size_t putInt(const char* key, int32_t v) { _i[key] = v; return 4; }
+  int32_t getInt(const char* key, int32_t def = 0) { auto it = _i.find(key); return it == _i.end() ? def : it->second; }
+  size_t putBool(const char* key, bool v) { _i[key] = v; return 1; }
+  bool getBool(const char* key, bool def = false) { auto it = _i.find(key); return it == _i.end() ? def : it->second != 0; }
+  size_t putBytes(const char* key, const void* v, size_t len) {
+    _b[key].assign((const uint8_t*)v, (const uint8_t*)v + len); return len;
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    auto it = _b.find(key);
+    if (it == _b.end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+  bool remove(const char* key) { return _s.erase(key) + _i.erase(key) + _b.erase(key) > 0; }
+
+ private:
+  std::map<std::string, std::string> _s;
+  std::map<std::string, int32_t> _i;
+  std::map<std::string, std::vector<uint8_t>> _b;
+};
+
+#endif
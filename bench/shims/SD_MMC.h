@@ -0,0 +1,10 @@
+#ifndef HOST_SD_MMC_H
+#define HOST_SD_MMC_H
+
+#include "FS.h"
+
+// "SD карта" - каталог на ПК (по умолчанию текущий, см. BENCH_SD_ROOT)
+class HostSDMMC : public fs::FS {};
+extern HostSDMMC SD_MMC;
+
+#endif
@@ -0,0 +1,137 @@
+#include "UniversalTelegramBot.h"
+#include "Config.h"
+#include "Uploader.h"
+
+// Экранирование строки для JSON
+static std::string jsonString(const char* s) {
+  std::string out = "\"";
+  for (; *s; s++) {
+    switch (*s) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:   out += *s;
+    }
+  }
+  return out + "\"";
+}
+
+// Позиция значения поля "key" в JSON (после двоеточия и пробелов), или npos
+static size_t jsonValue(const std::string& json, const char* key, size_t from = 0) {
+  std::string k = std::string("\"") + key + "\"";
+  size_t p = json.find(k, from);
+  if (p == std::string::npos) return p;
+  p += k.size();
+  while (p < json.size() && (json[p] == ' ' || json[p] == ':')) p++;
+  return p;
+}
+
+static void appendUtf8(std::string& out, unsigned cp) {
+  if (cp < 0x80) {
+    out += (char)cp;
+  } else if (cp < 0x800) {
+    out += (char)(0xC0 | (cp >> 6));
+    out += (char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += (char)(0xE0 | (cp >> 12));
+    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+    out += (char)(0x80 | (cp & 0x3F));
+  } else {
+    out += (char)(0xF0 | (cp >> 18));
+    out += (char)(0x80 | ((cp >> 12) & 0x3F));
+    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+    out += (char)(0x80 | (cp & 0x3F));
+  }
+}
+
+// Чтение JSON строки или числа, начиная с позиции значения
+static std::string jsonScalar(const std::string& json, size_t p) {
+  std::string out;
+  if (p >= json.size()) return out;
+  if (json[p] != '"') {
+    while (p < json.size() && (isalnum((unsigned char)json[p]) || json[p] == '-' || json[p] == '.')) out += json[p++];
+    return out;
+  }
+  for (p++; p < json.size() && json[p] != '"'; p++) {
+    if (json[p] != '\\') { out += json[p]; continue; }
+    char e = json[++p];
+    if (e == 'n') out += '\n';
+    else if (e == 't') out += '\t';
+    else if (e == 'r') out += '\r';
+    else if (e == 'u') {
+      unsigned cp = strtoul(json.substr(p + 1, 4).c_str(), nullptr, 16);
+      p += 4;
+      // Суррогатная пара
+      if (cp >= 0xD800 && cp < 0xDC00 && json.compare(p + 1, 2, "\\u") == 0) {
+        unsigned lo = strtoul(json.substr(p + 3, 4).c_str(), nullptr, 16);
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        p += 6;
+      }
+      appendUtf8(out, cp);
+    }
+    else out += e;
+  }
+  return out;
+}
+
+bool UniversalTelegramBot::request(const char* method, const char* path, const std::string& json, std::string& body) {
+  _client->stop();
+  if (!_client->connect(TELEGRAM_API_HOST, TELEGRAM_API_PORT)) return false;
+
+  _client->printf("%s /bot%s/%s HTTP/1.1\r\n", method, _token.c_str(), path);
+  _client->printf("Host: %s\r\n", TELEGRAM_API_HOST);
+  _client->print("Connection: close\r\n");
+  if (!json.empty()) {
+    _client->print("Content-Type: application/json\r\n");
+    _client->printf("Content-Length: %u\r\n", (unsigned)json.size());
+  }
+  _client->print("\r\n");
+  if (!json.empty()) _client->write((const uint8_t*)json.data(), json.size());
+
+  static char resp[16 * 1024];
+  int status = readHttpResponse(*_client, resp, sizeof(resp), 10000);
+  _client->stop();
+  body = resp;
+  return status == 200 && jsonScalar(body, jsonValue(body, "ok")) == "true";
+}
+
+int UniversalTelegramBot::getUpdates(long offset) {
+  char path[64];
+  snprintf(path, sizeof(path), "getUpdates?offset=%ld&limit=%d", offset, HANDLE_MESSAGES);
+  std::string body;
+  if (!request("GET", path, "", body)) return 0;
+
+  int count = 0;
+  size_t p = 0;
+  while (count < HANDLE_MESSAGES && (p = jsonValue(body, "update_id", p)) != std::string::npos) {
+    telegramMessage& m = messages[count++];
+    m.update_id = atoi(jsonScalar(body, p).c_str());
+    size_t chat = jsonValue(body, "chat", p);
+    m.chat_id = jsonScalar(body, jsonValue(body, "id", chat)).c_str();
+    m.text = jsonScalar(body, jsonValue(body, "text", p)).c_str();
+    last_message_received = m.update_id;
+  }
+  return count;
+}
+
+bool UniversalTelegramBot::sendMessage(const String& chat_id, const String& text, const String& parse_mode, int) {
+  std::string json = "{\"chat_id\":" + jsonString(chat_id.c_str()) + ",\"text\":" + jsonString(text.c_str()) +
+                     ",\"parse_mode\":" + jsonString(parse_mode.c_str()) + "}";
+  std::string body;
+  return request("POST", "sendMessage", json, body);
+}
+
+bool UniversalTelegramBot::sendMessageWithReplyKeyboard(const String& chat_id, const String& text,
+                                                        const String& parse_mode, const String& keyboard,
+                                                        bool resize, bool oneTime, bool selective) {
+  std::string json = "{\"chat_id\":" + jsonString(chat_id.c_str()) + ",\"text\":" + jsonString(text.c_str()) +
+                     ",\"parse_mode\":" + jsonString(parse_mode.c_str()) +
+                     ",\"reply_markup\":{\"keyboard\":" + keyboard.c_str() +
+                     ",\"resize_keyboard\":" + (resize ? "true" : "false") +
+                     ",\"one_time_keyboard\":" + (oneTime ? "true" : "false") +
+                     ",\"selective\":" + (selective ? "true" : "false") + "}}";
+  std::string body;
+  return request("POST", "sendMessage", json, body);
+}
@@ -0,0 +1,38 @@
+#ifndef HOST_UNIVERSAL_TELEGRAM_BOT_H
+#define HOST_UNIVERSAL_TELEGRAM_BOT_H
+
+// Замена библиотеки UniversalTelegramBot: те же методы, запросы идут
+// на TELEGRAM_API_HOST:TELEGRAM_API_PORT по HTTP без TLS.
+#include "Arduino.h"
+#include "Client.h"
+
+#define HANDLE_MESSAGES 1
+
+struct telegramMessage {
+  String text;
+  String chat_id;
+  String from_name;
+  int update_id = 0;
+};
+
+class UniversalTelegramBot {
+ public:
+  UniversalTelegramBot(const String& token, Client& client) : _token(token), _client(&client) {}
+
+  int getUpdates(long offset);
+  bool sendMessage(const String& chat_id, const String& text, const String& parse_mode = "", int message_id = 0);
+  bool sendMessageWithReplyKeyboard(const String& chat_id, const String& text, const String& parse_mode,
+                                    const String& keyboard, bool resize = false, bool oneTime = false,
+                                    bool selective = false);
+
+  telegramMessage messages[HANDLE_MESSAGES];
+  long last_message_received = 0;
+
+ private:
+  bool request(const char* method, const char* path, const std::string& json, std::string& body);
+
+  String _token;
+  Client* _client;
+};
+
+#endif
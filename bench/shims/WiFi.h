@@ -0,0 +1,16 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+// На ПК сеть всегда "подключена"
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+class HostWiFi {
+ public:
+  wl_status_t status() { return WL_CONNECTED; }
+  int8_t RSSI() { return -60; }
+};
+extern HostWiFi WiFi;
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef HOST_WIFI_CLIENT_SECURE_H
+#define HOST_WIFI_CLIENT_SECURE_H
+
+#include "Client.h"
+
+// Обычный TCP сокет вместо TLS: локальная заглушка Bot API работает по HTTP
+class WiFiClientSecure : public Client {
+ public:
+  ~WiFiClientSecure() { stop(); }
+
+  void setInsecure() {}
+  void setHandshakeTimeout(unsigned long) {}
+
+  int connect(const char* host, uint16_t port) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  uint8_t connected() override;
+  void stop() override;
+  using Print::write;
+
+ private:
+  int fill(int timeoutMs);
+
+  int _fd = -1;
+  bool _eof = false;
+  uint8_t _rx[4096];
+  size_t _rxPos = 0;
+  size_t _rxLen = 0;
+};
+
+#endif
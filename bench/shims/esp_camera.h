@@ -0,0 +1,46 @@
+#ifndef HOST_ESP_CAMERA_H
+#define HOST_ESP_CAMERA_H
+
+// Только типы и таблицы, которые нужны модулям проекта. Камеры на ПК нет.
+#include <cstdint>
+
+typedef enum {
+  FRAMESIZE_96X96, FRAMESIZE_QQVGA, FRAMESIZE_QCIF, FRAMESIZE_HQVGA, FRAMESIZE_240X240,
+  FRAMESIZE_QVGA, FRAMESIZE_CIF, FRAMESIZE_HVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA,
+  FRAMESIZE_XGA, FRAMESIZE_HD, FRAMESIZE_SXGA, FRAMESIZE_UXGA, FRAMESIZE_INVALID
+} framesize_t;
+
+typedef struct {
+  uint16_t width;
+  uint16_t height;
+} resolution_info_t;
+
+extern const resolution_info_t resolution[];
+
+typedef struct {
+  framesize_t framesize;
+  uint8_t quality;
+} camera_status_t;
+
+#define OV2640_PID 0x26
+
+typedef struct {
+  uint8_t MIDH;
+  uint8_t MIDL;
+  uint16_t PID;
+  uint8_t VER;
+} sensor_id_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor {
+  sensor_id_t id;
+  camera_status_t status;
+  int (*set_framesize)(sensor_t* sensor, framesize_t framesize);
+  int (*set_quality)(sensor_t* sensor, int quality);
+  int (*set_res_raw)(sensor_t* sensor, int startX, int startY, int endX, int endY, int offsetX, int offsetY,
+                     int totalX, int totalY, int outputX, int outputY, bool scale, bool binning);
+};
+
+inline sensor_t* esp_camera_sensor_get() { return nullptr; }
+
+#endif
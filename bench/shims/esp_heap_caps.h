@@ -0,0 +1,16 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <cstdlib>
+#include <cstdint>
+
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline size_t heap_caps_get_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef HOST_ESP_MEMORY_UTILS_H
+#define HOST_ESP_MEMORY_UTILS_H
+
+inline bool esp_ptr_external_ram(const void*) { return false; }
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// Минимальная замена FreeRTOS поверх std::thread (задачи, очереди, семафоры)
+#include <cstdint>
+#include <cstddef>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))  // 1 тик = 1 мс
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack,
+                                   void* arg, UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t handle);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+// Двоичный семафор = очередь на один элемент нулевого размера
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1, 0); }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { return xQueueSend(s, nullptr, 0); }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) { return xQueueReceive(s, nullptr, wait); }
+
+#endif
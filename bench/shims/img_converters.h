@@ -0,0 +1,12 @@
+#ifndef HOST_IMG_CONVERTERS_H
+#define HOST_IMG_CONVERTERS_H
+
+typedef enum {
+  JPG_SCALE_NONE,
+  JPG_SCALE_2X,
+  JPG_SCALE_4X,
+  JPG_SCALE_8X,
+  JPG_SCALE_MAX = JPG_SCALE_8X
+} jpg_scale_t;
+
+#endif